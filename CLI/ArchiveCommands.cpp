@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Command.h"
+#include "Print.h"
+#include "TableArchive.h"
+
+#include <chrono>
+#include <filesystem>
+
+namespace Octopus
+{
+
+SUBCOMMAND_CALLBACK(subcommand_archive)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    const String& compression_name = context.arguments_string[0];
+    const String& archive_filepath = context.arguments_string[1];
+    TRY_ASSIGN(const BlockCompression compression, parse_block_compression(compression_name));
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const TableSnapshot table_snapshot = table->snapshot();
+    TRY(TableArchive::save(archive_filepath, table_snapshot, compression));
+
+    const auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+    const auto elapsed_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_time).count();
+
+    std::error_code error_code;
+    const auto archive_size = std::filesystem::file_size(archive_filepath, error_code);
+    if (error_code)
+        return Result(Result::FileError);
+
+    Print::line(
+        "Archived {} tickets to '{}' in {} ms ({} bytes).",
+        table_snapshot.entry_count(),
+        archive_filepath,
+        elapsed_milliseconds,
+        archive_size
+    );
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_archive_find)
+{
+    const String& archive_filepath = context.arguments_string[0];
+    const String& ticket_code = context.arguments_string[1];
+
+    // NOTE: Only the header and the block index are read when the archive is opened, and only the block that can
+    //       contain the ticket is read and decompressed.
+    TRY_ASSIGN(const OwnPtr<TableArchive> archive, TableArchive::open(archive_filepath));
+
+    auto result_or_ticket_id = transform_from_base_36<u64>(ticket_code, archive->ticket_code_check_character());
+    if (result_or_ticket_id.is_result())
+    {
+        const Result result = result_or_ticket_id.release_result();
+        if (result.get_code() != Result::IdInvalid)
+            return result;
+
+        Print::line("Ticket ID '{}' is not valid.", ticket_code);
+        return IterationDecision::Continue;
+    }
+
+    auto result_or_entry = archive->find_entry(result_or_ticket_id.release_value());
+    if (result_or_entry.is_result())
+    {
+        const Result result = result_or_entry.release_result();
+        if (result.get_code() != Result::IdNotFound)
+            return result;
+
+        Print::line("Ticket ID '{}' is not in the archive.", ticket_code);
+        return IterationDecision::Continue;
+    }
+
+    const TableEntry entry = result_or_entry.release_value();
+    Print::line("The following entry was found in the archive:");
+    Print::LocalIndent local_indent;
+    Print::line("First name: {}", entry.first_name);
+    Print::line("Last name:  {}", entry.last_name);
+    Print::line("Grade:      {}{}", entry.grade, entry.grade_id);
+    Print::line("Scan count: {}", entry.metadata.scan_count.load());
+
+    return IterationDecision::Continue;
+}
+
+// NOTE: clang-format doesn't handle initializer lists very well, so we disable it while
+// defining the subcommands. It makes the code a lot easier to read.
+// clang-format off
+// NOLINTBEGIN
+
+static SubcommandRegister s_archive_subcommand(
+    "archive", { "archive" },
+    {
+        { CommandSyntax::Type::String, "compression" },
+        { CommandSyntax::Type::String, "archive_filepath" }
+    },
+    subcommand_archive,
+    "Writes all tickets to a binary archive, compressed with 'none' or 'lz4'. It can be opened as a database."
+);
+
+static SubcommandRegister s_archive_find_subcommand(
+    "archive_find", { "archive_find" },
+    {
+        { CommandSyntax::Type::String, "archive_filepath" },
+        { CommandSyntax::Type::String, "ticket_id" }
+    },
+    subcommand_archive_find,
+    "Prints a ticket from an archive, reading only the block that contains it."
+);
+
+// NOLINTEND
+// clang-format on
+
+} // namespace Octopus
@@ -8,7 +8,34 @@
 namespace Octopus
 {
 
-HashMap<String, PrimaryCommandRegister> PrimaryCommandRegister::s_registers;
-HashMap<String, SubcommandRegister> SubcommandRegister::s_registers;
+HashMap<String, PrimaryCommandRegister>& PrimaryCommandRegister::get_registers()
+{
+    static HashMap<String, PrimaryCommandRegister> s_registers;
+    return s_registers;
+}
+
+HashMap<String, SubcommandRegister>& SubcommandRegister::get_registers()
+{
+    static HashMap<String, SubcommandRegister> s_registers;
+    return s_registers;
+}
+
+SubcommandDispatchTable::SubcommandDispatchTable(const PrimaryCommandRegister& primary_command)
+{
+    for (const auto& subcommand_name : primary_command.subcommands())
+    {
+        const SubcommandRegister& subcommand = SubcommandRegister::registers().at(subcommand_name);
+        for (const auto& operation_code : subcommand.operation_codes())
+            m_candidates[operation_code].push_back({ subcommand_name, &subcommand });
+    }
+}
+
+Span<const SubcommandDispatchTable::Candidate> SubcommandDispatchTable::find(const String& operation_code) const
+{
+    auto candidates_it = m_candidates.find(operation_code);
+    if (candidates_it == m_candidates.end())
+        return {};
+    return candidates_it->second;
+}
 
 } // namespace Octopus
@@ -7,7 +7,9 @@
 
 #include "Core.h"
 #include "Result.h"
+#include "Socket.h"
 #include "Table.h"
+#include "TableCursor.h"
 
 namespace Octopus
 {
@@ -66,10 +68,22 @@ public:
 
     NODISCARD ALWAYS_INLINE bool allow_subcommands() const { return m_allow_subcommands; }
 
+    /// Only set when the program is a client station of a scan server. In this case, there is no local table.
+    ALWAYS_INLINE void set_server_connection(OwnPtr<Socket> connection) { m_server_connection = std::move(connection); }
+    NODISCARD ALWAYS_INLINE const OwnPtr<Socket>& server_connection() const { return m_server_connection; }
+
+    /// The cursor of the last paged listing, which the 'next' subcommand continues.
+    NODISCARD ALWAYS_INLINE OwnPtr<TableCursor>& print_cursor() { return m_print_cursor; }
+    ALWAYS_INLINE void set_print_page_size(usize page_size) { m_print_page_size = page_size; }
+    NODISCARD ALWAYS_INLINE usize print_page_size() const { return m_print_page_size; }
+
 private:
     bool m_keeps_running = true;
     String m_primary_command_name;
     OwnPtr<Table> m_table;
+    OwnPtr<Socket> m_server_connection;
+    OwnPtr<TableCursor> m_print_cursor;
+    usize m_print_page_size = 0;
     bool m_allow_subcommands;
 };
 
@@ -94,11 +108,12 @@ public:
         , m_callback(callback)
         , m_help_info(help_info)
     {
-        VERIFY(!s_registers.contains(String(name)));
-        s_registers.insert({ String(name), std::move(*this) });
+        HashMap<String, PrimaryCommandRegister>& registers = get_registers();
+        VERIFY(!registers.contains(String(name)));
+        registers.insert({ String(name), std::move(*this) });
     }
 
-    NODISCARD static const HashMap<String, PrimaryCommandRegister>& registers() { return s_registers; }
+    NODISCARD static const HashMap<String, PrimaryCommandRegister>& registers() { return get_registers(); }
 
     NODISCARD const HashSet<String>& operation_codes() const { return m_operation_codes; }
     NODISCARD const CommandSyntax& syntax() const { return m_syntax; }
@@ -107,7 +122,9 @@ public:
     NODISCARD StringView help_info() const { return m_help_info; }
 
 private:
-    static HashMap<String, PrimaryCommandRegister> s_registers;
+    // NOTE: The registers are constructed on first use, as the commands are registered by the static objects of
+    //       other translation units, which can be initialized before this one.
+    static HashMap<String, PrimaryCommandRegister>& get_registers();
 
 private:
     HashSet<String> m_operation_codes;
@@ -152,11 +169,12 @@ public:
         , m_callback(callback)
         , m_help_info(help_info)
     {
-        VERIFY(!s_registers.contains(String(name)));
-        s_registers.insert({ String(name), std::move(*this) });
+        HashMap<String, SubcommandRegister>& registers = get_registers();
+        VERIFY(!registers.contains(String(name)));
+        registers.insert({ String(name), std::move(*this) });
     }
 
-    NODISCARD static const HashMap<String, SubcommandRegister>& registers() { return s_registers; }
+    NODISCARD static const HashMap<String, SubcommandRegister>& registers() { return get_registers(); }
 
     NODISCARD const HashSet<String>& operation_codes() const { return m_operation_codes; }
     NODISCARD const CommandSyntax& syntax() const { return m_syntax; }
@@ -164,7 +182,9 @@ public:
     NODISCARD StringView help_info() const { return m_help_info; }
 
 private:
-    static HashMap<String, SubcommandRegister> s_registers;
+    // NOTE: The registers are constructed on first use, as the commands are registered by the static objects of
+    //       other translation units, which can be initialized before this one.
+    static HashMap<String, SubcommandRegister>& get_registers();
 
 private:
     HashSet<String> m_operation_codes;
@@ -173,4 +193,29 @@ private:
     StringView m_help_info;
 };
 
+///
+/// The subcommands of a primary command, indexed by their operation codes. It is built once, after the program
+/// context is created, so resolving a command line is a single lookup instead of a walk over all the registers.
+/// The command structure must be validated before building it, which guarantees that for a given operation code
+/// at most one candidate can match any list of arguments.
+///
+class SubcommandDispatchTable
+{
+public:
+    struct Candidate
+    {
+        String name;
+        const SubcommandRegister* subcommand;
+    };
+
+public:
+    explicit SubcommandDispatchTable(const PrimaryCommandRegister& primary_command);
+
+    /// Returns the subcommands that accept the given operation code, or an empty span if there are none.
+    NODISCARD Span<const Candidate> find(const String& operation_code) const;
+
+private:
+    HashMap<String, Vector<Candidate>> m_candidates;
+};
+
 } // namespace Octopus
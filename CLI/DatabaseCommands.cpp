@@ -7,6 +7,8 @@
 #include "MathUtils.h"
 #include "Print.h"
 
+#include <format>
+
 namespace Octopus
 {
 
@@ -65,7 +67,7 @@ SUBCOMMAND_CALLBACK(subcommand_emit)
     Print::line("The following ticket was emitted:");
     Print::push_indentation();
 
-    Print::line("ID:         {}", transform_to_base_36(ticket_id));
+    Print::line("ID:         {}", table->format_ticket_code(ticket_id));
     Print::line("First name: {}", inserted_entry.first_name);
     Print::line("Last name:  {}", inserted_entry.last_name);
     Print::line("Grade:      {}{}", static_cast<u32>(inserted_entry.grade), inserted_entry.grade_id);
@@ -74,6 +76,24 @@ SUBCOMMAND_CALLBACK(subcommand_emit)
     return IterationDecision::Continue;
 }
 
+/// Returns an empty value if the code was typed wrong, which is detected by its check character, without accessing
+/// the table. The mistake is reported to the user.
+static ResultOr<Optional<TicketID>> parse_typed_ticket_code(const Table& table, const String& ticket_code)
+{
+    auto result_or_ticket_id = table.parse_ticket_code(ticket_code);
+    if (result_or_ticket_id.is_result())
+    {
+        const Result result = result_or_ticket_id.release_result();
+        if (result.get_code() != Result::IdInvalid)
+            return result;
+
+        Print::line("Ticket ID '{}' is not valid.", ticket_code);
+        return Optional<TicketID> {};
+    }
+
+    return Optional<TicketID>(result_or_ticket_id.release_value());
+}
+
 SUBCOMMAND_CALLBACK(subcommand_remove)
 {
     auto& table = context.program_context->table();
@@ -81,7 +101,10 @@ SUBCOMMAND_CALLBACK(subcommand_remove)
         return Result(Result::UnknownError);
 
     const String& ticket_id_as_string = context.arguments_string[0];
-    TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_id_as_string));
+    TRY_ASSIGN(const Optional<TicketID> typed_ticket_id, parse_typed_ticket_code(*table, ticket_id_as_string));
+    if (!typed_ticket_id.has_value())
+        return IterationDecision::Continue;
+    const TicketID ticket_id = typed_ticket_id.value();
 
     auto result_or_entry = table->get_entry(ticket_id);
     if (result_or_entry.is_result())
@@ -123,8 +146,12 @@ SUBCOMMAND_CALLBACK(subcommand_scan)
         return Result(Result::UnknownError);
 
     const String& ticket_id_string = context.arguments_string[0];
-    TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_id_string));
-    auto result_or_entry = table->get_entry(ticket_id);
+    TRY_ASSIGN(const Optional<TicketID> typed_ticket_id, parse_typed_ticket_code(*table, ticket_id_string));
+    if (!typed_ticket_id.has_value())
+        return IterationDecision::Continue;
+    const TicketID ticket_id = typed_ticket_id.value();
+
+    auto result_or_entry = table->scan_ticket(ticket_id);
 
     if (result_or_entry.is_result())
     {
@@ -138,9 +165,11 @@ SUBCOMMAND_CALLBACK(subcommand_scan)
         return Result(result_id);
     }
 
-    TableEntry& entry = result_or_entry.release_value();
+    // NOTE: The entry describes the ticket as it was before this scan.
+    const TableEntry entry = result_or_entry.release_value();
+    const u32 scan_count = entry.metadata.scan_count.load();
 
-    if (entry.metadata.scan_count == 0)
+    if (scan_count == 0)
     {
         Print::line("Ticket ID '{}' was never scanned before.", ticket_id_string);
         Print::push_indentation();
@@ -150,16 +179,15 @@ SUBCOMMAND_CALLBACK(subcommand_scan)
     }
     else
     {
-        Print::line("Ticket ID '{}' was scanned {} times.", ticket_id_string, entry.metadata.scan_count);
+        TRY_ASSIGN(const String last_scan_date, format_scan_timestamp(entry.metadata.last_scan_timestamp));
+        Print::line("Ticket ID '{}' was scanned {} times.", ticket_id_string, scan_count);
         Print::push_indentation();
         Print::line("Name:           {} {}", entry.last_name, entry.first_name);
         Print::line("Grade:          {}{}", static_cast<u32>(entry.grade), entry.grade_id);
-        Print::line("Last scan date: {}", entry.metadata.last_scan_date);
+        Print::line("Last scan date: {}", last_scan_date);
         Print::pop_indentation();
     }
 
-    TRY(table->increment_ticket_scan_count(ticket_id));
-
     // TODO: The database should be saved to disk, in case the program will crash later.
     //       This will ensure that all tickets scanned until that moment were correctly registered.
 
@@ -173,8 +201,12 @@ SUBCOMMAND_CALLBACK(subcommand_change)
         return Result(Result::UnknownError);
 
     const String& ticket_id_as_string = context.arguments_string[0];
-    TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_id_as_string));
-    TRY_ASSIGN(TableEntry & entry, table->get_entry(ticket_id));
+    TRY_ASSIGN(const Optional<TicketID> typed_ticket_id, parse_typed_ticket_code(*table, ticket_id_as_string));
+    if (!typed_ticket_id.has_value())
+        return IterationDecision::Continue;
+    const TicketID ticket_id = typed_ticket_id.value();
+
+    TRY_ASSIGN(const TableEntry& entry, table->get_entry(ticket_id));
 
     const String& new_first_name = context.arguments_string[2];
     const String& new_last_name = context.arguments_string[1];
@@ -200,12 +232,12 @@ SUBCOMMAND_CALLBACK(subcommand_change)
         Print::line("Last name:  {} -> {}", entry.last_name, new_entry.last_name);
 
     if (entry.grade != new_entry.grade)
-        Print::line("Grade:      {} -> {}", static_cast<u32>(entry.grade), static_cast<u32>(entry.grade));
+        Print::line("Grade:      {} -> {}", static_cast<u32>(entry.grade), static_cast<u32>(new_entry.grade));
 
     if (entry.grade_id != new_entry.grade_id)
         Print::line("Grade ID:   {} -> {}", entry.grade_id, new_entry.grade_id);
 
-    entry = new_entry;
+    TRY(table->change_entry(ticket_id, std::move(new_entry)));
     return IterationDecision::Continue;
 }
 
@@ -215,54 +247,45 @@ SUBCOMMAND_CALLBACK(subcommand_print)
     if (!table)
         return Result(Result::UnknownError);
 
-    HashMap<u8, HashMap<char, u32>> number_of_tickets_per_class;
+    // NOTE: The name index of the snapshot is already sorted, so distributing its entries to their classes keeps
+    //       them sorted. The index is shared with every other listing of the same version of the table.
+    const TableSnapshot table_snapshot = table->snapshot();
+    TRY_ASSIGN(const RefPtr<const TableEntryIndex> name_index, table_snapshot.get_name_index());
+
+    HashMap<u8, HashMap<char, Vector<const TableEntryMap::value_type*>>> tickets_per_class;
+    for (const TableEntryMap::value_type* table_entry : *name_index)
+        tickets_per_class[table_entry->second.grade][table_entry->second.grade_id].push_back(table_entry);
 
     for (u8 grade = 9; grade <= 12; ++grade)
     {
         for (char grade_id = 'A'; grade_id <= 'F'; ++grade_id)
         {
-            std::map<String, TicketID> tickets_in_class;
-
-            TRY(table->iterate_over_entries(
-                [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
-                {
-                    if (entry.grade == grade && entry.grade_id == grade_id)
-                    {
-                        const String full_name = entry.last_name + " " + entry.first_name;
-                        tickets_in_class[full_name] = ticket_id;
-                    }
-
-                    return IterationDecision::Continue;
-                }
-            ));
-
-            number_of_tickets_per_class[grade][grade_id] = tickets_in_class.size();
-
+            const auto& tickets_in_class = tickets_per_class[grade][grade_id];
             if (tickets_in_class.empty())
                 continue;
 
             Print::line("Class {}{} ({} tickets):", static_cast<u32>(grade), grade_id, tickets_in_class.size());
             Print::LocalIndent local_indent;
 
-            for (const auto& [full_name, ticket_id] : tickets_in_class)
+            for (const auto* table_entry : tickets_in_class)
             {
-                const auto ticket_id_string = transform_to_base_36(ticket_id);
-                Print::line("{}: {}", ticket_id_string, full_name);
+                const auto& [ticket_id, entry] = *table_entry;
+                const String ticket_code = table_snapshot.format_ticket_code(ticket_id);
+                Print::line("{}: {} {}", ticket_code, entry.last_name, entry.first_name);
             }
 
             Print::new_line();
         }
     }
 
-    TRY_ASSIGN(const usize total_ticket_count, context.program_context->table()->entry_count());
-    Print::line("Total tickets count: {}", total_ticket_count);
+    Print::line("Total tickets count: {}", table_snapshot.entry_count());
     Print::line("----------------");
 
     for (u8 grade = 9; grade <= 12; ++grade)
     {
         for (char grade_id = 'A'; grade_id <= 'F'; ++grade_id)
         {
-            const u32 ticket_count = number_of_tickets_per_class[grade][grade_id];
+            const usize ticket_count = tickets_per_class[grade][grade_id].size();
             if (ticket_count == 0)
                 continue;
 
@@ -277,6 +300,238 @@ SUBCOMMAND_CALLBACK(subcommand_print)
     return IterationDecision::Continue;
 }
 
+SUBCOMMAND_CALLBACK(subcommand_summary)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    const TableStatistics& statistics = table->statistics();
+    Print::line(
+        "{} tickets, {} scanned, {} scans in total.",
+        statistics.ticket_count(),
+        statistics.scanned_ticket_count(),
+        statistics.scan_count()
+    );
+    Print::line("----------------");
+
+    for (u8 grade = ALLOWED_GRADE_LOW; grade <= ALLOWED_GRADE_HIGH; ++grade)
+    {
+        for (char grade_id = ALLOWED_GRADE_ID_LOW; grade_id <= ALLOWED_GRADE_ID_HIGH; ++grade_id)
+        {
+            const TableClassStatistics& class_statistics = statistics.get_class(grade, grade_id);
+            const u32 ticket_count = class_statistics.ticket_count.load(std::memory_order_relaxed);
+            if (ticket_count == 0)
+                continue;
+
+            const String padding = (grade < 10) ? " " : String();
+            Print::line(
+                "{}{}:{} {} tickets, {} scanned, {} scans",
+                static_cast<u32>(grade),
+                grade_id,
+                padding,
+                ticket_count,
+                class_statistics.scanned_ticket_count.load(std::memory_order_relaxed),
+                class_statistics.scan_count.load(std::memory_order_relaxed)
+            );
+        }
+
+        if (grade != ALLOWED_GRADE_HIGH)
+            Print::line("----------------");
+    }
+
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_rate)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    const ScanRateRecorder& scan_rate = table->statistics().scan_rate();
+    const i64 now = static_cast<i64>(std::time(nullptr));
+
+    Print::line("{} scans in the last minute.", scan_rate.count_recent(now, 60));
+    const float quarter_hour_rate = static_cast<float>(scan_rate.count_recent(now, 15 * 60)) / 15.0f;
+    Print::line("{:.1f} scans per minute over the last 15 minutes.", quarter_hour_rate);
+    Print::line("Scans of the last 10 minutes, one minute at a time:");
+    Print::LocalIndent local_indent;
+
+    for (i64 minutes_ago = 9; minutes_ago >= 0; --minutes_ago)
+    {
+        const i64 end_timestamp = now + 1 - minutes_ago * 60;
+        const u64 scan_count = scan_rate.count_range(end_timestamp - 60, end_timestamp);
+        if (minutes_ago == 0)
+            Print::line("Last minute: {}", scan_count);
+        else
+            Print::line("{} min ago:  {}", minutes_ago, scan_count);
+    }
+
+    return IterationDecision::Continue;
+}
+
+/// Prints the next page of the cursor, followed by the position of the page in the listing.
+static ResultOr<void> print_cursor_page(const Table& table, TableCursor& cursor, usize page_size)
+{
+    const usize first_position = cursor.position();
+    TRY(cursor.next_page(
+        page_size,
+        [&table](TicketID ticket_id, const TableEntry& entry) -> ResultOr<void>
+        {
+            Print::line(
+                "{}: {} {} ({}{}, scanned {} times)",
+                table.format_ticket_code(ticket_id),
+                entry.last_name,
+                entry.first_name,
+                static_cast<u32>(entry.grade),
+                entry.grade_id,
+                entry.metadata.scan_count.load()
+            );
+            return {};
+        }
+    ));
+
+    if (cursor.position() == first_position)
+    {
+        Print::line("There are no more tickets to print.");
+        return {};
+    }
+
+    Print::new_line();
+    Print::line("Tickets {}-{} of {}.", first_position + 1, cursor.position(), cursor.entry_count());
+    if (!cursor.has_reached_end())
+        Print::line("Use 'next' to print the next page.");
+    return {};
+}
+
+SUBCOMMAND_CALLBACK(subcommand_print_page)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    const i64 page_size = context.arguments_integer[0];
+    if (page_size <= 0)
+        return Result(Result::InvalidParameter);
+
+    TRY_ASSIGN(const TableCursorOrder order, TableCursor::parse_order(context.arguments_string[0]));
+    TRY_ASSIGN(OwnPtr<TableCursor> cursor, TableCursor::create(table->snapshot(), order));
+
+    auto& print_cursor = context.program_context->print_cursor();
+    print_cursor = std::move(cursor);
+    context.program_context->set_print_page_size(static_cast<usize>(page_size));
+
+    TRY(print_cursor_page(*table, *print_cursor, static_cast<usize>(page_size)));
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_next)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    auto& print_cursor = context.program_context->print_cursor();
+    if (!print_cursor)
+    {
+        Print::line("No listing was started. Use 'print [order_by] [page_size]' to start one.");
+        return IterationDecision::Continue;
+    }
+
+    TRY(print_cursor_page(*table, *print_cursor, context.program_context->print_page_size()));
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_search)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    TRY_ASSIGN(
+        const Vector<TableNameMatch> matches,
+        table->find_similar_names(
+            context.arguments_string[0],
+            context.arguments_string[1],
+            default_similar_name_match_count
+        )
+    );
+
+    if (matches.empty())
+    {
+        Print::line("No ticket was emitted for a similar name.");
+        return IterationDecision::Continue;
+    }
+
+    Print::line("The following tickets were emitted for similar names:");
+    Print::LocalIndent local_indent;
+    for (const TableNameMatch& match : matches)
+    {
+        Print::line(
+            "{}: {} {} ({}{}, {} edits away)",
+            table->format_ticket_code(match.ticket_id),
+            match.entry.last_name,
+            match.entry.first_name,
+            static_cast<u32>(match.entry.grade),
+            match.entry.grade_id,
+            match.distance
+        );
+    }
+
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_migrate_codes)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    if (table->ticket_code_check_character() == Base36CheckCharacter::LuhnMod36)
+    {
+        Print::line("The ticket codes already end with a check character.");
+        return IterationDecision::Continue;
+    }
+
+    // NOTE: The ticket IDs don't change, only the way they are written. The old codes keep working until the
+    //       format is switched, which happens only after the whole list of new codes was written.
+    const TableSnapshot table_snapshot = table->snapshot();
+    String reissued_codes = "old_code,new_code,last_name,first_name,class\n";
+    TRY(table_snapshot.iterate_over_entries(
+        [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+        {
+            const String old_code = transform_to_base_36(ticket_id);
+            const String new_code = transform_to_base_36(ticket_id, Base36CheckCharacter::LuhnMod36);
+            std::format_to(
+                std::back_inserter(reissued_codes),
+                "{},{},{},{},{}{}\n",
+                old_code,
+                new_code,
+                entry.last_name,
+                entry.first_name,
+                static_cast<u32>(entry.grade),
+                entry.grade_id
+            );
+            return IterationDecision::Continue;
+        }
+    ));
+
+    const String& reissue_filepath = context.arguments_string[0];
+    std::ofstream output(reissue_filepath, std::ios::binary);
+    if (!output.is_open())
+        return Result(Result::InvalidFilepath);
+    output.write(reissued_codes.data(), static_cast<std::streamsize>(reissued_codes.size()));
+    output.close();
+    if (output.fail())
+        return Result(Result::FileError);
+
+    table->set_ticket_code_check_character(Base36CheckCharacter::LuhnMod36);
+    Print::line("The codes of {} tickets were reissued to '{}'.", table_snapshot.entry_count(), reissue_filepath);
+    Print::line("Save the database and write the tickets again, as the old codes are no longer accepted.");
+    return IterationDecision::Continue;
+}
+
 // NOTE: clang-format doesn't handle initializer lists very well, so we disable it while
 // defining the primary commands. It makes the code a lot easier to read.
 // clang-format off
@@ -285,7 +540,11 @@ SUBCOMMAND_CALLBACK(subcommand_print)
 static PrimaryCommandRegister s_open_database_command(
     "open_database", { "db" },
     { { CommandSyntax::Type::String, "database_filepath" } },
-    { "save", "emit", "remove", "change", "scan", "print" },
+    {
+        "save", "emit", "remove", "change", "scan", "print", "print_page", "next", "summary", "rate",
+        "query", "query_ordered", "query_projected",
+        "export", "export_query", "export_query_ordered", "search", "migrate_codes", "archive", "archive_find"
+    },
     primary_command_open_database,
     "Opens a database from a file."
 );
@@ -293,7 +552,11 @@ static PrimaryCommandRegister s_open_database_command(
 static PrimaryCommandRegister s_create_database_command(
     "create_database", { "db" },
     {},
-    { "save", "emit", "remove", "change", "scan", "print" },
+    {
+        "save", "emit", "remove", "change", "scan", "print", "print_page", "next", "summary", "rate",
+        "query", "query_ordered", "query_projected",
+        "export", "export_query", "export_query_ordered", "search", "migrate_codes", "archive", "archive_find"
+    },
     primary_command_create_database,
     "Creates a new empty memory-only database."
 );
@@ -355,6 +618,56 @@ static SubcommandRegister s_print_subcommand(
     "Prints all tickets to the console."
 );
 
+static SubcommandRegister s_summary_subcommand(
+    "summary", { "summary", "sum" },
+    {},
+    subcommand_summary,
+    "Prints the number of tickets, scanned tickets and scans of every class."
+);
+
+static SubcommandRegister s_rate_subcommand(
+    "rate", { "rate" },
+    {},
+    subcommand_rate,
+    "Prints the number of scans per minute."
+);
+
+static SubcommandRegister s_print_page_subcommand(
+    "print_page", { "print" },
+    {
+        { CommandSyntax::Type::String, "order_by" },
+        { CommandSyntax::Type::Integer, "page_size" }
+    },
+    subcommand_print_page,
+    "Prints the first page of tickets, sorted by 'id', 'name' or 'scans'."
+);
+
+static SubcommandRegister s_next_subcommand(
+    "next", { "next", "n" },
+    {},
+    subcommand_next,
+    "Prints the next page of the last paged listing."
+);
+
+static SubcommandRegister s_search_subcommand(
+    "search", { "search" },
+    {
+        { CommandSyntax::Type::String, "last_name" },
+        { CommandSyntax::Type::String, "first_name" }
+    },
+    subcommand_search,
+    "Finds the tickets emitted for the names closest to the given, possibly misspelled, name."
+);
+
+static SubcommandRegister s_migrate_codes_subcommand(
+    "migrate_codes", { "migrate_codes" },
+    {
+        { CommandSyntax::Type::String, "reissue_filepath" }
+    },
+    subcommand_migrate_codes,
+    "Appends a check character to the ticket codes, and writes the new code of every ticket to a CSV file."
+);
+
 // NOLINTEND
 // clang-format on
 
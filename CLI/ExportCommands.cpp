@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Command.h"
+#include "Print.h"
+#include "Query.h"
+#include "TableExport.h"
+
+#include <chrono>
+
+namespace Octopus
+{
+
+static ResultOr<void>
+export_table(const SubcommandContext& context, StringView filter = "all", StringView order = {})
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    const String& format_name = context.arguments_string[0];
+    const String& export_filepath = context.arguments_string[1];
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const TableSnapshot table_snapshot = table->snapshot();
+
+    TRY_ASSIGN(const TableExportFormat format, TableExporter::parse_format(format_name));
+    TRY_ASSIGN(const OwnPtr<Query> query, Query::create(table_snapshot, filter, order));
+    TRY_ASSIGN(const OwnPtr<TableExporter> exporter, TableExporter::create(export_filepath, format));
+
+    TRY(query->execute(
+        table_snapshot,
+        [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+        {
+            TRY(exporter->write_entry(table_snapshot, ticket_id, entry));
+            return IterationDecision::Continue;
+        }
+    ));
+    TRY(exporter->finish());
+
+    const auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+    const auto elapsed_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_time).count();
+    Print::line(
+        "Exported {} tickets to '{}' in {} ms.", exporter->exported_entry_count(), export_filepath, elapsed_milliseconds
+    );
+    return {};
+}
+
+SUBCOMMAND_CALLBACK(subcommand_export)
+{
+    TRY(export_table(context));
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_export_query)
+{
+    TRY(export_table(context, context.arguments_string[2]));
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_export_query_ordered)
+{
+    TRY(export_table(context, context.arguments_string[2], context.arguments_string[3]));
+    return IterationDecision::Continue;
+}
+
+// NOTE: clang-format doesn't handle initializer lists very well, so we disable it while
+// defining the subcommands. It makes the code a lot easier to read.
+// clang-format off
+// NOLINTBEGIN
+
+static SubcommandRegister s_export_subcommand(
+    "export", { "export" },
+    {
+        { CommandSyntax::Type::String, "format" },
+        { CommandSyntax::Type::String, "export_filepath" }
+    },
+    subcommand_export,
+    "Exports all tickets to a 'csv' or 'jsonl' file."
+);
+
+static SubcommandRegister s_export_query_subcommand(
+    "export_query", { "export" },
+    {
+        { CommandSyntax::Type::String, "format" },
+        { CommandSyntax::Type::String, "export_filepath" },
+        { CommandSyntax::Type::String, "filter" }
+    },
+    subcommand_export_query,
+    "Exports the tickets that satisfy the filter (see 'query') to a 'csv' or 'jsonl' file."
+);
+
+static SubcommandRegister s_export_query_ordered_subcommand(
+    "export_query_ordered", { "export" },
+    {
+        { CommandSyntax::Type::String, "format" },
+        { CommandSyntax::Type::String, "export_filepath" },
+        { CommandSyntax::Type::String, "filter" },
+        { CommandSyntax::Type::String, "order_by" }
+    },
+    subcommand_export_query_ordered,
+    "Exports the tickets that satisfy the filter to a 'csv' or 'jsonl' file, sorted by the given fields."
+);
+
+// NOLINTEND
+// clang-format on
+
+} // namespace Octopus
@@ -8,6 +8,8 @@
 #include "Print.h"
 #include "Table.h"
 
+#include <chrono>
+
 namespace Octopus
 {
 
@@ -140,11 +142,20 @@ static void print_help_command()
 
     Print::push_indentation();
     Print::new_line();
+
+    Print::line("Append '--script [filepath]' to run the subcommands from a file ('-' reads the standard input).");
+    Print::line("Append '--quiet' as well to print only the lines that failed and the summary of the script.");
 }
 
 struct CommandLineArguments
 {
     Vector<String> arguments;
+
+    /// If set, the subcommands are read from this file instead of being typed interactively.
+    Optional<String> script_filepath;
+
+    /// If set, the output of the subcommands run from the script is suppressed.
+    bool is_script_quiet = false;
 };
 
 struct CommandMatch
@@ -305,109 +316,335 @@ static void print_help_subcommand(const PrimaryCommandRegister& primary_command)
     Print::new_line();
 }
 
-static ResultOr<bool> get_subcommand(CommandMatch& out_command_match, const OwnPtr<ProgramContext>& program_context)
+ALWAYS_INLINE static bool is_command_line_whitespace(char character)
 {
-    String operation_code;
-    Vector<String> arguments;
+    return character == ' ' || character == '\t' || character == '\r';
+}
 
+/// Splits a command line into the operation code and its arguments. Both output parameters are cleared first,
+/// so that the same containers can be reused across many command lines without reallocating.
+static void split_command_line(StringView command_line, String& out_operation_code, Vector<String>& out_arguments)
+{
+    out_operation_code.clear();
+    out_arguments.clear();
+
+    usize offset = 0;
+    while (offset < command_line.size())
     {
-        std::string command_line_string;
-        std::getline(std::cin, command_line_string);
-        std::stringstream command_line = std::stringstream(command_line_string);
+        while (offset < command_line.size() && is_command_line_whitespace(command_line[offset]))
+            ++offset;
 
-        command_line >> operation_code;
-        if (operation_code.empty())
-            return false;
+        const usize token_offset = offset;
+        while (offset < command_line.size() && !is_command_line_whitespace(command_line[offset]))
+            ++offset;
 
-        while (command_line.good())
-        {
-            String argument;
-            command_line >> argument;
-            arguments.emplace_back(std::move(argument));
-        }
+        if (token_offset == offset)
+            break;
+
+        const StringView token = command_line.substr(token_offset, offset - token_offset);
+        if (out_operation_code.empty())
+            out_operation_code = token;
+        else
+            out_arguments.emplace_back(token);
     }
+}
 
-    const PrimaryCommandRegister& primary_command =
-        PrimaryCommandRegister::registers().at(program_context->get_primary_command_name());
+struct SubcommandMatch
+{
+    const SubcommandDispatchTable::Candidate* candidate = nullptr;
+    Vector<String> arguments_string;
+    Vector<i64> arguments_integer;
+};
 
-    if (operation_code == "help")
+/// Because the command structure is validated at startup, at most one candidate can match the arguments,
+/// so the first matching syntax is the only one.
+static bool match_subcommand(
+    Span<const SubcommandDispatchTable::Candidate> candidates,
+    const Vector<String>& arguments,
+    SubcommandMatch& out_match
+)
+{
+    for (const auto& candidate : candidates)
     {
-        print_help_subcommand(primary_command);
-        return false;
+        if (get_command_arguments(
+                candidate.subcommand->syntax(), arguments, out_match.arguments_string, out_match.arguments_integer
+            ))
+        {
+            out_match.candidate = &candidate;
+            return true;
+        }
     }
 
-    // All the subcommands that match the operation code, but might not match the syntax.
-    Vector<String> subcommand_candidates;
+    return false;
+}
 
-    // All the subcommands that match both the operation code and the syntax.
-    // If this vector doesn't have exactly one element, invalid usage is invoked.
-    Vector<CommandMatch> subcommand_matches;
+static ResultOr<bool> get_subcommand(
+    SubcommandMatch& out_subcommand_match,
+    const SubcommandDispatchTable& dispatch_table,
+    const OwnPtr<ProgramContext>& program_context
+)
+{
+    String operation_code;
+    Vector<String> arguments;
 
-    for (const auto& subcommand_name : primary_command.subcommands())
     {
-        const auto& subcommand = SubcommandRegister::registers().at(subcommand_name);
-        if (!subcommand.operation_codes().contains(operation_code))
-            continue;
-        subcommand_candidates.push_back(subcommand_name);
-
-        const auto& syntax = subcommand.syntax();
-        Vector<String> arguments_string;
-        Vector<i64> arguments_integer;
+        // The output of the previous subcommand must be visible before waiting for the next one.
+        Print::flush();
 
-        if (get_command_arguments(syntax, arguments, arguments_string, arguments_integer))
+        String command_line;
+        if (!std::getline(std::cin, command_line))
         {
-            CommandMatch match;
-            match.name = subcommand_name;
-            match.arguments_string = std::move(arguments_string);
-            match.arguments_integer = std::move(arguments_integer);
-            subcommand_matches.emplace_back(std::move(match));
+            // The standard input was closed (or it was a pipe that reached its end), so there is nothing
+            // left to process.
+            program_context->exit_program();
+            return false;
         }
+
+        split_command_line(command_line, operation_code, arguments);
+        if (operation_code.empty())
+            return false;
     }
 
-    if (subcommand_matches.empty())
+    if (operation_code == "help")
     {
-        Print::line("No subcommand with operation code '{}' matches the syntax.", operation_code);
-        Print::push_indentation();
+        print_help_subcommand(PrimaryCommandRegister::registers().at(program_context->get_primary_command_name()));
+        return false;
+    }
 
-        for (const auto& name : subcommand_candidates)
-        {
-            const SubcommandRegister& subcommand = SubcommandRegister::registers().at(name);
-            Print::line("The subcommand '{}' requires the syntax:", name);
+    const auto candidates = dispatch_table.find(operation_code);
+    if (match_subcommand(candidates, arguments, out_subcommand_match))
+        return true;
 
-            Print::push_indentation();
-            Print::string_with_indent({});
-            print_command_syntax(subcommand.syntax());
-            Print::pop_indentation();
-            Print::new_line();
-        }
+    Print::line("No subcommand with operation code '{}' matches the syntax.", operation_code);
+    Print::push_indentation();
 
+    for (const auto& candidate : candidates)
+    {
+        Print::line("The subcommand '{}' requires the syntax:", candidate.name);
+
+        Print::push_indentation();
+        Print::string_with_indent({});
+        print_command_syntax(candidate.subcommand->syntax());
         Print::pop_indentation();
-        return false;
+        Print::new_line();
     }
-    if (subcommand_matches.size() > 1)
+
+    Print::pop_indentation();
+    return false;
+}
+
+/// A String variable accepts any argument (including integers), so two syntaxes with the same number of
+/// variables can always match the same command line and can't be told apart.
+static bool are_syntaxes_ambiguous(const CommandSyntax& syntax_a, const CommandSyntax& syntax_b)
+{
+    return syntax_a.variables().size() == syntax_b.variables().size();
+}
+
+static bool check_operation_codes(StringView name, const HashSet<String>& operation_codes)
+{
+    for (const auto& operation_code : operation_codes)
     {
-        Print::line("More than one subcommand matches both the operation code and the syntax.");
-        return false;
+        if (operation_code.empty() || operation_code == "help")
+        {
+            Print::line("The command '{}' has an invalid operation code '{}'.", name, operation_code);
+            return false;
+        }
     }
 
-    out_command_match = subcommand_matches[0];
     return true;
 }
 
+/// Validates the registered commands, so that dispatching never has to deal with missing or ambiguous commands.
 static bool check_command_structure()
 {
-    for (const auto& [name, command] : PrimaryCommandRegister::registers())
+    const auto& primary_commands = PrimaryCommandRegister::registers();
+    for (auto command_it = primary_commands.begin(); command_it != primary_commands.end(); ++command_it)
     {
-        for (const auto& subcommand : command.subcommands())
+        const auto& [name, command] = *command_it;
+        if (!check_operation_codes(name, command.operation_codes()))
+            return false;
+
+        for (auto other_it = std::next(command_it); other_it != primary_commands.end(); ++other_it)
         {
-            if (!SubcommandRegister::registers().contains(subcommand))
+            const auto& [other_name, other_command] = *other_it;
+            for (const auto& operation_code : command.operation_codes())
+            {
+                if (other_command.operation_codes().contains(operation_code) &&
+                    are_syntaxes_ambiguous(command.syntax(), other_command.syntax()))
+                {
+                    Print::line(
+                        "The commands '{}' and '{}' are ambiguous for '-{}'.", name, other_name, operation_code
+                    );
+                    return false;
+                }
+            }
+        }
+
+        for (const auto& subcommand_name : command.subcommands())
+        {
+            auto subcommand_it = SubcommandRegister::registers().find(subcommand_name);
+            if (subcommand_it == SubcommandRegister::registers().end())
+            {
+                Print::line("The command '{}' uses the unknown subcommand '{}'.", name, subcommand_name);
                 return false;
+            }
+
+            const SubcommandRegister& subcommand = subcommand_it->second;
+            if (!check_operation_codes(subcommand_name, subcommand.operation_codes()))
+                return false;
+
+            for (const auto& other_name : command.subcommands())
+            {
+                auto other_it = SubcommandRegister::registers().find(other_name);
+                if (other_name <= subcommand_name || other_it == SubcommandRegister::registers().end())
+                    continue;
+
+                const SubcommandRegister& other_subcommand = other_it->second;
+                for (const auto& operation_code : subcommand.operation_codes())
+                {
+                    if (other_subcommand.operation_codes().contains(operation_code) &&
+                        are_syntaxes_ambiguous(subcommand.syntax(), other_subcommand.syntax()))
+                    {
+                        Print::line(
+                            "The subcommands '{}' and '{}' are ambiguous for '{}'.",
+                            subcommand_name,
+                            other_name,
+                            operation_code
+                        );
+                        return false;
+                    }
+                }
+            }
         }
     }
 
     return true;
 }
 
+static ResultOr<String> read_subcommand_script(const String& script_filepath)
+{
+    if (script_filepath == "-")
+        return String(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+
+    std::ifstream input(script_filepath, std::ios::binary | std::ios::ate);
+    if (!input.is_open())
+        return Result(Result::InvalidFilepath);
+
+    const std::streamoff file_size = input.tellg();
+    if (file_size < 0)
+        return Result(Result::FileError);
+
+    String script;
+    script.resize(static_cast<usize>(file_size));
+    input.seekg(0);
+    if (!input.read(script.data(), file_size))
+        return Result(Result::FileError);
+
+    return script;
+}
+
+/// Runs all subcommands from the given script file, without the interactive decorations. The output of the
+/// subcommands is printed unless the script is quiet, and the lines that failed and a final summary are always printed.
+/// If any line failed or was rejected, the script as a whole fails, so that the exit code of the program reports it.
+static ResultOr<void> run_subcommand_script(
+    const OwnPtr<ProgramContext>& program_context,
+    const SubcommandDispatchTable& dispatch_table,
+    const String& script_filepath,
+    bool is_script_quiet
+)
+{
+    TRY_ASSIGN(const String script, read_subcommand_script(script_filepath));
+
+    u32 line_count = 0;
+    u32 executed_count = 0;
+    u32 failed_count = 0;
+    u32 rejected_count = 0;
+
+    // These are reused across all lines, in order to avoid reallocating them for every subcommand.
+    String operation_code;
+    Vector<String> arguments;
+    SubcommandMatch subcommand_match;
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    usize line_offset = 0;
+    while (line_offset < script.size() && program_context->keeps_running())
+    {
+        usize line_end = script.find('\n', line_offset);
+        if (line_end == String::npos)
+            line_end = script.size();
+
+        const StringView line = StringView(script).substr(line_offset, line_end - line_offset);
+        line_offset = line_end + 1;
+        ++line_count;
+
+        split_command_line(line, operation_code, arguments);
+        if (operation_code.empty() || operation_code.starts_with('#'))
+            continue;
+
+        if (!match_subcommand(dispatch_table.find(operation_code), arguments, subcommand_match))
+        {
+            Print::line("Line {}: '{}' doesn't match any subcommand.", line_count, operation_code);
+            ++rejected_count;
+            continue;
+        }
+
+        const SubcommandContext subcommand_context(
+            program_context, std::move(subcommand_match.arguments_string), std::move(subcommand_match.arguments_integer)
+        );
+
+        Optional<Result::Code> failure_code;
+        IterationDecision decision = IterationDecision::Continue;
+
+        {
+            Optional<Print::LocalMute> local_mute;
+            if (is_script_quiet)
+                local_mute.emplace();
+
+            auto result_or_iteration_decision = subcommand_match.candidate->subcommand->callback()(subcommand_context);
+            if (result_or_iteration_decision.is_result())
+                failure_code = result_or_iteration_decision.release_result().get_code();
+            else
+                decision = result_or_iteration_decision.release_value();
+        }
+
+        ++executed_count;
+        if (failure_code.has_value())
+        {
+            Print::line(
+                "Line {}: subcommand '{}' failed with result code: {}",
+                line_count,
+                subcommand_match.candidate->name,
+                static_cast<u32>(*failure_code)
+            );
+            ++failed_count;
+        }
+
+        if (decision == IterationDecision::Break)
+            break;
+    }
+
+    const auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+    const auto elapsed_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_time).count();
+
+    Print::line(
+        "Script '{}' finished in {} ms: {} lines, {} subcommands executed, {} failed, {} rejected.",
+        script_filepath,
+        elapsed_milliseconds,
+        line_count,
+        executed_count,
+        failed_count,
+        rejected_count
+    );
+
+    // A replay that skipped any of its lines must not look like a successful one to the caller of the program.
+    if (failed_count + rejected_count > 0)
+        return Result(Result::ScriptFailed);
+
+    Print::flush();
+    return {};
+}
+
 static ResultOr<void> guarded_main(const CommandLineArguments& arguments)
 {
     if (!check_command_structure())
@@ -424,16 +661,26 @@ static ResultOr<void> guarded_main(const CommandLineArguments& arguments)
     if (!program_context->allow_subcommands())
         return {};
 
+    const SubcommandDispatchTable dispatch_table =
+        SubcommandDispatchTable(PrimaryCommandRegister::registers().at(program_context->get_primary_command_name()));
+
+    if (arguments.script_filepath.has_value())
+    {
+        return run_subcommand_script(
+            program_context, dispatch_table, *arguments.script_filepath, arguments.is_script_quiet
+        );
+    }
+
     while (program_context->keeps_running())
     {
-        CommandMatch subcommand_match;
+        SubcommandMatch subcommand_match;
         Print::push_indentation();
-        TRY_ASSIGN(const bool subcommand_is_valid, get_subcommand(subcommand_match, program_context));
+        TRY_ASSIGN(const bool subcommand_is_valid, get_subcommand(subcommand_match, dispatch_table, program_context));
         Print::pop_indentation();
         if (!subcommand_is_valid)
             continue;
 
-        const auto& subcommand = SubcommandRegister::registers().at(subcommand_match.name);
+        const SubcommandRegister& subcommand = *subcommand_match.candidate->subcommand;
 
         const SubcommandContext subcommand_context(
             program_context, subcommand_match.arguments_string, subcommand_match.arguments_integer
@@ -446,7 +693,9 @@ static ResultOr<void> guarded_main(const CommandLineArguments& arguments)
         {
             auto result_code = result_or_iteration_decision.release_result().get_code();
             Print::line(
-                "Subcommand '{}' failed with result code: {}", subcommand_match.name, static_cast<u32>(result_code)
+                "Subcommand '{}' failed with result code: {}",
+                subcommand_match.candidate->name,
+                static_cast<u32>(result_code)
             );
 
             Print::pop_indentation();
@@ -469,15 +718,47 @@ int main(int argument_count, char** arguments)
 {
     Octopus::CommandLineArguments cmd_arguments;
     for (int index = 1; index < argument_count; ++index)
+    {
+        if (Octopus::StringView(arguments[index]) == "--script")
+        {
+            if (index + 1 == argument_count)
+            {
+                Octopus::Print::line("Invalid usage!");
+                Octopus::Print::line("The '--script' option must be followed by the script filepath.");
+                Octopus::Print::flush();
+                return 0;
+            }
+
+            cmd_arguments.script_filepath = arguments[++index];
+            continue;
+        }
+
+        if (Octopus::StringView(arguments[index]) == "--quiet")
+        {
+            cmd_arguments.is_script_quiet = true;
+            continue;
+        }
+
         cmd_arguments.arguments.push_back(arguments[index]);
+    }
+
+    if (cmd_arguments.is_script_quiet && !cmd_arguments.script_filepath.has_value())
+    {
+        Octopus::Print::line("Invalid usage!");
+        Octopus::Print::line("The '--quiet' option can only be used together with the '--script' option.");
+        Octopus::Print::flush();
+        return 0;
+    }
 
     auto execution_result = Octopus::guarded_main(cmd_arguments);
     if (execution_result.is_result())
     {
         const int result_code = static_cast<int>(execution_result.release_result().get_code());
         Octopus::Print::line("Primary command failed with result code: {}", result_code);
+        Octopus::Print::flush();
         return result_code;
     }
 
+    Octopus::Print::flush();
     return 0;
 }
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "MetricsEndpoint.h"
+
+#include <format>
+
+namespace Octopus
+{
+
+/// Scrapers send short requests, so anything longer than this is rejected instead of being buffered.
+static constexpr usize max_metrics_request_size = 8 * 1024;
+
+/// Scrapers are local and few, so a handful of simultaneous connections is plenty.
+static constexpr usize max_metrics_connection_count = 16;
+
+ResultOr<OwnPtr<MetricsEndpoint>> MetricsEndpoint::create(u16 port)
+{
+    TRY_ASSIGN(OwnPtr<Socket> listener, Socket::listen_on_localhost(port));
+    TRY(listener->set_non_blocking());
+
+    OwnPtr<MetricsEndpoint> endpoint = OwnPtr<MetricsEndpoint>(new MetricsEndpoint(std::move(listener)));
+    if (!endpoint)
+        return Result(Result::OutOfMemory);
+    return endpoint;
+}
+
+void MetricsEndpoint::append_poll_requests(Vector<SocketPollRequest>& poll_requests) const
+{
+    SocketPollRequest listener_poll_request;
+    listener_poll_request.socket = m_listener.get();
+    listener_poll_request.wants_to_read = m_connections.size() < max_metrics_connection_count;
+    poll_requests.push_back(listener_poll_request);
+
+    for (const auto& connection : m_connections)
+    {
+        SocketPollRequest poll_request;
+        poll_request.socket = connection->socket.get();
+        poll_request.wants_to_read = !connection->has_complete_request;
+        poll_request.wants_to_write = connection->response_offset < connection->response.size();
+        poll_requests.push_back(poll_request);
+    }
+}
+
+void MetricsEndpoint::process_poll_results(Span<const SocketPollRequest> poll_results)
+{
+    // NOTE: The first poll request belongs to the listener. The others belong to the connections, in the same order.
+    for (usize index = 0; index < m_connections.size(); ++index)
+    {
+        const SocketPollRequest& poll_result = poll_results[index + 1];
+        Connection& connection = *m_connections[index];
+
+        if ((poll_result.is_readable || poll_result.has_failed) && !connection.has_complete_request)
+            receive_request(connection);
+        if (poll_result.is_writable && connection.response_offset < connection.response.size())
+            send_response(connection);
+    }
+
+    std::erase_if(m_connections, [](const OwnPtr<Connection>& connection) { return connection->is_closed; });
+
+    if (poll_results[0].is_readable)
+        accept_pending_connections();
+}
+
+bool MetricsEndpoint::has_pending_requests() const
+{
+    for (const auto& connection : m_connections)
+    {
+        if (connection->has_complete_request && connection->response.empty())
+            return true;
+    }
+
+    return false;
+}
+
+void MetricsEndpoint::send_responses(StringView metrics)
+{
+    for (const auto& connection : m_connections)
+    {
+        if (!connection->has_complete_request || !connection->response.empty())
+            continue;
+
+        if (connection->request.starts_with("GET /metrics ") || connection->request.starts_with("GET /metrics?"))
+        {
+            connection->response = std::format(
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: {}\r\n"
+                "Connection: close\r\n\r\n",
+                metrics.size()
+            );
+            connection->response.append(metrics);
+        }
+        else
+        {
+            connection->response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        // The request isn't needed anymore, so its memory is released while the response is being sent.
+        String().swap(connection->request);
+        send_response(*connection);
+    }
+
+    std::erase_if(m_connections, [](const OwnPtr<Connection>& connection) { return connection->is_closed; });
+}
+
+void MetricsEndpoint::accept_pending_connections()
+{
+    while (m_connections.size() < max_metrics_connection_count)
+    {
+        auto result_or_socket = m_listener->accept();
+        if (result_or_socket.is_result())
+            return;
+
+        OwnPtr<Socket> socket = result_or_socket.release_value();
+        if (!socket)
+            return;
+        if (socket->set_non_blocking().is_result())
+            continue;
+
+        OwnPtr<Connection> connection = std::make_unique<Connection>();
+        if (!connection)
+            return;
+
+        connection->socket = std::move(socket);
+        m_connections.push_back(std::move(connection));
+    }
+}
+
+void MetricsEndpoint::receive_request(Connection& connection)
+{
+    u8 buffer[1024];
+    while (true)
+    {
+        auto result_or_received_byte_count = connection.socket->receive_some(buffer);
+        if (result_or_received_byte_count.is_result())
+        {
+            connection.is_closed = true;
+            return;
+        }
+
+        const usize received_byte_count = result_or_received_byte_count.release_value();
+        if (received_byte_count == 0)
+            return;
+
+        connection.request.append(reinterpret_cast<const char*>(buffer), received_byte_count);
+        if (connection.request.find("\r\n\r\n") != String::npos)
+        {
+            connection.has_complete_request = true;
+            return;
+        }
+
+        if (connection.request.size() > max_metrics_request_size)
+        {
+            connection.is_closed = true;
+            return;
+        }
+    }
+}
+
+void MetricsEndpoint::send_response(Connection& connection)
+{
+    const StringView pending_response = StringView(connection.response).substr(connection.response_offset);
+    const Span<const u8> pending_bytes =
+        Span<const u8>(reinterpret_cast<const u8*>(pending_response.data()), pending_response.size());
+
+    auto result_or_sent_byte_count = connection.socket->send_some(pending_bytes);
+    if (result_or_sent_byte_count.is_result())
+    {
+        connection.is_closed = true;
+        return;
+    }
+
+    connection.response_offset += result_or_sent_byte_count.release_value();
+    if (connection.response_offset == connection.response.size())
+        connection.is_closed = true;
+}
+
+} // namespace Octopus
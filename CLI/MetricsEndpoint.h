@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Socket.h"
+
+namespace Octopus
+{
+
+///
+/// Minimal HTTP endpoint on localhost that answers 'GET /metrics' with the metrics of the scan server, in the
+/// Prometheus text format. It is driven by the event loop of the server, using non-blocking sockets, so scraping
+/// it never blocks the stations. Every connection serves a single request and is then closed.
+///
+class MetricsEndpoint
+{
+public:
+    OCT_NONCOPYABLE(MetricsEndpoint)
+    OCT_NONMOVABLE(MetricsEndpoint)
+    ~MetricsEndpoint() = default;
+
+public:
+    static ResultOr<OwnPtr<MetricsEndpoint>> create(u16 port);
+
+    /// Appends the poll requests of the endpoint, which must be passed back to process_poll_results() in the
+    /// same order, after the poll.
+    void append_poll_requests(Vector<SocketPollRequest>& poll_requests) const;
+    void process_poll_results(Span<const SocketPollRequest> poll_results);
+
+    /// Whether a scraper is waiting for the metrics, which means they should be collected.
+    NODISCARD bool has_pending_requests() const;
+    /// Answers all the pending requests with the given metrics and closes the finished connections.
+    void send_responses(StringView metrics);
+
+private:
+    struct Connection
+    {
+        OwnPtr<Socket> socket;
+        String request;
+        String response;
+        usize response_offset = 0;
+        bool has_complete_request = false;
+        bool is_closed = false;
+    };
+
+private:
+    explicit MetricsEndpoint(OwnPtr<Socket> listener)
+        : m_listener(std::move(listener))
+    {
+    }
+
+    void accept_pending_connections();
+    static void receive_request(Connection& connection);
+    static void send_response(Connection& connection);
+
+private:
+    OwnPtr<Socket> m_listener;
+    Vector<OwnPtr<Connection>> m_connections;
+};
+
+} // namespace Octopus
@@ -4,65 +4,152 @@
  */
 
 #include "Print.h"
-#include <iostream>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+#else
+    #include <cerrno>
+    #include <unistd.h>
+#endif
 
 namespace Octopus
 {
 
-u32 Print::s_indentation_level = 0;
-String Print::s_indentation_buffer;
+thread_local Print::ThreadState Print::s_thread_state;
+std::atomic<bool> Print::s_is_synchronized = false;
 static constexpr u32 indentation_character_count = 2;
 
+static constexpr usize indentation_padding_length = 128;
+static constexpr char s_indentation_padding[indentation_padding_length + 1] =
+    "                                                                "
+    "                                                                ";
+
+/// The buffer is written to the console once it grows past this size, even if it was not explicitly flushed.
+static constexpr usize print_buffer_flush_threshold = 64 * 1024;
+
+/// Serializes the writes of the different threads, so that the content of a flush is never split.
+static std::mutex s_console_mutex;
+
+static void write_to_console(StringView output)
+{
+    const std::scoped_lock<std::mutex> lock(s_console_mutex);
+
+#ifdef _WIN32
+    const HANDLE console_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    while (!output.empty())
+    {
+        const DWORD byte_count = static_cast<DWORD>(std::min<usize>(output.size(), UINT32_MAX));
+        DWORD written_byte_count = 0;
+        if (!WriteFile(console_handle, output.data(), byte_count, &written_byte_count, nullptr))
+            return;
+        output.remove_prefix(written_byte_count);
+    }
+#else
+    while (!output.empty())
+    {
+        const ssize_t written_byte_count = write(STDOUT_FILENO, output.data(), output.size());
+        if (written_byte_count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        output.remove_prefix(static_cast<usize>(written_byte_count));
+    }
+#endif
+}
+
+Print::ThreadState::~ThreadState()
+{
+    // The output that the thread never flushed must not be lost.
+    if (!buffer.empty())
+        write_to_console(buffer);
+}
+
 void Print::string(StringView string)
 {
-    std::cout << string;
+    if (s_thread_state.is_muted)
+        return;
+    s_thread_state.buffer.append(string);
+    flush_if_full();
 }
 
 void Print::string_with_indent(StringView string)
 {
-    std::cout << s_indentation_buffer << string;
+    if (s_thread_state.is_muted)
+        return;
+    s_thread_state.buffer.append(get_indentation(s_thread_state.indentation_level));
+    s_thread_state.buffer.append(string);
+    flush_if_full();
 }
 
 void Print::line(StringView line)
 {
-    std::cout << s_indentation_buffer;
-    std::cout << line;
-    std::cout << '\n';
+    if (s_thread_state.is_muted)
+        return;
+    s_thread_state.buffer.append(get_indentation(s_thread_state.indentation_level));
+    s_thread_state.buffer.append(line);
+    end_line();
 }
 
 void Print::line_with_indent(u32 indentation_level, StringView line)
 {
-    s_indentation_level += indentation_level;
-    const u32 additional_indentation = indentation_level * indentation_character_count;
-    for (u32 indent_level = 0; indent_level < additional_indentation; ++indent_level)
-        s_indentation_buffer.push_back(' ');
-
-    Print::line(line);
-
-    for (u32 indent_level = 0; indent_level < additional_indentation; ++indent_level)
-        s_indentation_buffer.pop_back();
-    s_indentation_level -= indentation_level;
+    if (s_thread_state.is_muted)
+        return;
+    s_thread_state.buffer.append(get_indentation(s_thread_state.indentation_level + indentation_level));
+    s_thread_state.buffer.append(line);
+    end_line();
 }
 
 void Print::new_line()
 {
-    std::cout << '\n';
+    if (s_thread_state.is_muted)
+        return;
+    end_line();
+}
+
+void Print::flush()
+{
+    if (s_thread_state.buffer.empty())
+        return;
+
+    write_to_console(s_thread_state.buffer);
+    // The capacity of the buffer is kept, so it is allocated only once per thread.
+    s_thread_state.buffer.clear();
 }
 
 void Print::push_indentation(u32 level /*= 1*/)
 {
-    s_indentation_level += level;
-    const u32 additional_indentation = level * indentation_character_count;
-    for (u32 indent_level = 0; indent_level < additional_indentation; ++indent_level)
-        s_indentation_buffer.push_back(' ');
+    s_thread_state.indentation_level += level;
 }
 
 void Print::pop_indentation(u32 level /*= 1*/)
 {
-    s_indentation_level += level;
-    const u32 additional_indentation = level * indentation_character_count;
-    for (u32 indent_level = 0; indent_level < additional_indentation; ++indent_level)
-        s_indentation_buffer.pop_back();
+    s_thread_state.indentation_level -= std::min(level, s_thread_state.indentation_level);
+}
+
+StringView Print::get_indentation(u32 indentation_level)
+{
+    // NOTE: The indentation never gets anywhere near this deep, so deeper levels are simply clamped.
+    const usize space_count = static_cast<usize>(indentation_level) * indentation_character_count;
+    return StringView(s_indentation_padding, std::min(space_count, indentation_padding_length));
+}
+
+void Print::end_line()
+{
+    s_thread_state.buffer.push_back('\n');
+    if (s_is_synchronized.load(std::memory_order_relaxed))
+        flush();
+    else
+        flush_if_full();
+}
+
+void Print::flush_if_full()
+{
+    if (s_thread_state.buffer.size() >= print_buffer_flush_threshold)
+        flush();
 }
 
 } // namespace Octopus
@@ -11,6 +11,11 @@
 namespace Octopus
 {
 
+///
+/// All output is formatted into a buffer that belongs to the calling thread, so printing never takes a lock. The
+/// buffer is written to the console with a single system call when it is flushed, which happens explicitly, when
+/// the buffer grows large or when the thread exits.
+///
 class Print
 {
 public:
@@ -20,6 +25,22 @@ public:
         ALWAYS_INLINE ~LocalIndent() { Print::pop_indentation(); }
     };
 
+    /// Suppresses all output for the lifetime of the object. Used when running subcommands from a quiet script,
+    /// where the per-subcommand output would only slow down the execution.
+    struct LocalMute
+    {
+        ALWAYS_INLINE LocalMute()
+            : m_was_muted(Print::is_muted())
+        {
+            Print::set_muted(true);
+        }
+
+        ALWAYS_INLINE ~LocalMute() { Print::set_muted(m_was_muted); }
+
+    private:
+        bool m_was_muted;
+    };
+
 public:
     static void string(StringView string);
     static void string_with_indent(StringView string);
@@ -28,41 +49,87 @@ public:
 
     static void new_line();
 
+    /// Writes the output buffered by the calling thread to the console. Called after every interactive subcommand
+    /// and by long-running commands that never return.
+    static void flush();
+
     static void push_indentation(u32 level = 1);
     static void pop_indentation(u32 level = 1);
-    ALWAYS_INLINE static u32 get_indentation_level() { return s_indentation_level; }
+    ALWAYS_INLINE static u32 get_indentation_level() { return s_thread_state.indentation_level; }
+
+    ALWAYS_INLINE static void set_muted(bool is_muted) { s_thread_state.is_muted = is_muted; }
+    NODISCARD ALWAYS_INLINE static bool is_muted() { return s_thread_state.is_muted; }
+
+    /// In synchronized mode every thread flushes its buffer as soon as it completes a line, so the output of
+    /// commands that run in parallel shows up immediately and is only ever interleaved at line boundaries.
+    ALWAYS_INLINE static void set_synchronized(bool is_synchronized)
+    {
+        s_is_synchronized.store(is_synchronized, std::memory_order_relaxed);
+    }
 
     template<typename... Args>
     ALWAYS_INLINE static void string(StringView string_format, Args&&... arguments)
     {
-        const String formatted = std::vformat(string_format, std::make_format_args(std::forward<Args>(arguments)...));
-        Print::string(formatted);
+        if (s_thread_state.is_muted)
+            return;
+        format_to_buffer(string_format, std::make_format_args(std::forward<Args>(arguments)...));
+        flush_if_full();
     }
 
     template<typename... Args>
     ALWAYS_INLINE static void string_with_indent(StringView string_format, Args&&... arguments)
     {
-        const String formatted = std::vformat(string_format, std::make_format_args(std::forward<Args>(arguments)...));
-        Print::string_with_indent(formatted);
+        if (s_thread_state.is_muted)
+            return;
+        s_thread_state.buffer.append(get_indentation(s_thread_state.indentation_level));
+        format_to_buffer(string_format, std::make_format_args(std::forward<Args>(arguments)...));
+        flush_if_full();
     }
 
     template<typename... Args>
     ALWAYS_INLINE static void line(StringView line_format, Args&&... arguments)
     {
-        const String formatted = std::vformat(line_format, std::make_format_args(std::forward<Args>(arguments)...));
-        Print::line(formatted);
+        if (s_thread_state.is_muted)
+            return;
+        s_thread_state.buffer.append(get_indentation(s_thread_state.indentation_level));
+        format_to_buffer(line_format, std::make_format_args(std::forward<Args>(arguments)...));
+        end_line();
     }
 
     template<typename... Args>
     ALWAYS_INLINE static void line_with_indent(u32 indent_level, StringView line_format, Args&&... arguments)
     {
-        const String formatted = std::vformat(line_format, std::make_format_args(std::forward<Args>(arguments)...));
-        Print::line_with_indent(indent_level, formatted);
+        if (s_thread_state.is_muted)
+            return;
+        s_thread_state.buffer.append(get_indentation(s_thread_state.indentation_level + indent_level));
+        format_to_buffer(line_format, std::make_format_args(std::forward<Args>(arguments)...));
+        end_line();
     }
 
 private:
-    static u32 s_indentation_level;
-    static String s_indentation_buffer;
+    struct ThreadState
+    {
+        ~ThreadState();
+
+        String buffer;
+        u32 indentation_level = 0;
+        bool is_muted = false;
+    };
+
+private:
+    ALWAYS_INLINE static void format_to_buffer(StringView format, std::format_args format_arguments)
+    {
+        std::vformat_to(std::back_inserter(s_thread_state.buffer), format, format_arguments);
+    }
+
+    /// Returns the spaces that correspond to the indentation level, as a slice of a constant string.
+    NODISCARD static StringView get_indentation(u32 indentation_level);
+    static void end_line();
+    static void flush_if_full();
+
+private:
+    static thread_local ThreadState s_thread_state;
+    static std::atomic<bool> s_is_synchronized;
 };
 
 } // namespace Octopus
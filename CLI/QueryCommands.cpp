@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Command.h"
+#include "Print.h"
+#include "Query.h"
+
+namespace Octopus
+{
+
+static ResultOr<void>
+run_query(const SubcommandContext& context, StringView filter, StringView order, StringView columns)
+{
+    const auto& table = context.program_context->table();
+    if (!table)
+        return Result(Result::UnknownError);
+
+    const TableSnapshot table_snapshot = table->snapshot();
+    TRY_ASSIGN(const OwnPtr<Query> query, Query::create(table_snapshot, filter, order, columns));
+
+    String row;
+    for (const QueryField column : query->columns())
+    {
+        if (!row.empty())
+            row.append(" | ");
+        row.append(Query::get_field_name(column));
+    }
+    Print::line("{}", row);
+
+    usize match_count = 0;
+    TRY(query->execute(
+        table_snapshot,
+        [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+        {
+            row.clear();
+            for (const QueryField column : query->columns())
+            {
+                TRY_ASSIGN(const String value, Query::format_field(table_snapshot, column, ticket_id, entry));
+                if (!row.empty())
+                    row.append(" | ");
+                row.append(value);
+            }
+
+            Print::line("{}", row);
+            ++match_count;
+            return IterationDecision::Continue;
+        }
+    ));
+
+    Print::line("{} of {} tickets matched the query.", match_count, table_snapshot.entry_count());
+    return {};
+}
+
+SUBCOMMAND_CALLBACK(subcommand_query)
+{
+    TRY(run_query(context, context.arguments_string[0], {}, {}));
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_query_ordered)
+{
+    TRY(run_query(context, context.arguments_string[0], context.arguments_string[1], {}));
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_query_projected)
+{
+    TRY(run_query(context, context.arguments_string[0], context.arguments_string[1], context.arguments_string[2]));
+    return IterationDecision::Continue;
+}
+
+// NOTE: clang-format doesn't handle initializer lists very well, so we disable it while
+// defining the subcommands. It makes the code a lot easier to read.
+// clang-format off
+// NOLINTBEGIN
+
+static SubcommandRegister s_query_subcommand(
+    "query", { "query", "q" },
+    { { CommandSyntax::Type::String, "filter" } },
+    subcommand_query,
+    "Lists the tickets that satisfy the filter, such as 'class=11C&scans=0' or 'all'."
+);
+
+static SubcommandRegister s_query_ordered_subcommand(
+    "query_ordered", { "query", "q" },
+    {
+        { CommandSyntax::Type::String, "filter" },
+        { CommandSyntax::Type::String, "order_by" }
+    },
+    subcommand_query_ordered,
+    "Lists the tickets that satisfy the filter, sorted by the given fields, such as 'class,-scans'."
+);
+
+static SubcommandRegister s_query_projected_subcommand(
+    "query_projected", { "query", "q" },
+    {
+        { CommandSyntax::Type::String, "filter" },
+        { CommandSyntax::Type::String, "order_by" },
+        { CommandSyntax::Type::String, "columns" }
+    },
+    subcommand_query_projected,
+    "Lists the given fields of the tickets that satisfy the filter, such as 'id,last_name,scans'."
+);
+
+// NOLINTEND
+// clang-format on
+
+} // namespace Octopus
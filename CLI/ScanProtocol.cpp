@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "ScanProtocol.h"
+
+namespace Octopus
+{
+
+MessageWriter::MessageWriter()
+{
+    reset();
+}
+
+void MessageWriter::reset()
+{
+    // Reserve the space for the payload size, which is only known when the message is finished.
+    m_buffer.resize(scan_message_header_size);
+}
+
+void MessageWriter::write_u8(u8 value)
+{
+    m_buffer.push_back(value);
+}
+
+void MessageWriter::write_u32(u32 value)
+{
+    for (u32 byte_index = 0; byte_index < sizeof(u32); ++byte_index)
+        m_buffer.push_back(static_cast<u8>(value >> (byte_index * 8)));
+}
+
+void MessageWriter::write_u64(u64 value)
+{
+    for (u32 byte_index = 0; byte_index < sizeof(u64); ++byte_index)
+        m_buffer.push_back(static_cast<u8>(value >> (byte_index * 8)));
+}
+
+void MessageWriter::write_string(StringView value)
+{
+    // NOTE: Strings longer than the maximum length are truncated. Nothing that is sent over the protocol
+    //       (names, ticket codes and dates) comes anywhere close to this limit.
+    const u16 length = static_cast<u16>(std::min<usize>(value.size(), UINT16_MAX));
+    m_buffer.push_back(static_cast<u8>(length));
+    m_buffer.push_back(static_cast<u8>(length >> 8));
+    m_buffer.insert(m_buffer.end(), value.begin(), value.begin() + length);
+}
+
+ResultOr<Span<const u8>> MessageWriter::finish()
+{
+    const usize payload_size = m_buffer.size() - scan_message_header_size;
+    if (payload_size > max_scan_message_size)
+        return Result(Result::BufferOverflow);
+
+    for (u32 byte_index = 0; byte_index < scan_message_header_size; ++byte_index)
+        m_buffer[byte_index] = static_cast<u8>(payload_size >> (byte_index * 8));
+    return Span<const u8>(m_buffer);
+}
+
+ResultOr<Span<const u8>> MessageReader::read_bytes(usize byte_count)
+{
+    if (m_payload.size() - m_offset < byte_count)
+        return Result(Result::InvalidMessage);
+
+    const Span<const u8> bytes = m_payload.subspan(m_offset, byte_count);
+    m_offset += byte_count;
+    return bytes;
+}
+
+ResultOr<u8> MessageReader::read_u8()
+{
+    TRY_ASSIGN(const Span<const u8> bytes, read_bytes(sizeof(u8)));
+    return bytes[0];
+}
+
+ResultOr<u32> MessageReader::read_u32()
+{
+    TRY_ASSIGN(const Span<const u8> bytes, read_bytes(sizeof(u32)));
+
+    u32 value = 0;
+    for (u32 byte_index = 0; byte_index < sizeof(u32); ++byte_index)
+        value |= static_cast<u32>(bytes[byte_index]) << (byte_index * 8);
+    return value;
+}
+
+ResultOr<u64> MessageReader::read_u64()
+{
+    TRY_ASSIGN(const Span<const u8> bytes, read_bytes(sizeof(u64)));
+
+    u64 value = 0;
+    for (u32 byte_index = 0; byte_index < sizeof(u64); ++byte_index)
+        value |= static_cast<u64>(bytes[byte_index]) << (byte_index * 8);
+    return value;
+}
+
+ResultOr<String> MessageReader::read_string()
+{
+    TRY_ASSIGN(const Span<const u8> length_bytes, read_bytes(sizeof(u16)));
+    const u16 length = static_cast<u16>(length_bytes[0] | (length_bytes[1] << 8));
+
+    TRY_ASSIGN(const Span<const u8> characters, read_bytes(length));
+    return String(reinterpret_cast<const char*>(characters.data()), characters.size());
+}
+
+static ResultOr<u32> decode_message_size(const u8* header)
+{
+    u32 payload_size = 0;
+    for (u32 byte_index = 0; byte_index < scan_message_header_size; ++byte_index)
+        payload_size |= static_cast<u32>(header[byte_index]) << (byte_index * 8);
+
+    if (payload_size == 0 || payload_size > max_scan_message_size)
+        return Result(Result::InvalidMessage);
+    return payload_size;
+}
+
+ResultOr<void> send_message(Socket& socket, MessageWriter& message)
+{
+    TRY_ASSIGN(const Span<const u8> frame, message.finish());
+    TRY(socket.send_all(frame));
+    return {};
+}
+
+ResultOr<usize> peek_message(Span<const u8> buffer, Span<const u8>& out_payload)
+{
+    if (buffer.size() < scan_message_header_size)
+        return 0;
+
+    TRY_ASSIGN(const u32 payload_size, decode_message_size(buffer.data()));
+    if (buffer.size() - scan_message_header_size < payload_size)
+        return 0;
+
+    out_payload = buffer.subspan(scan_message_header_size, payload_size);
+    return scan_message_header_size + payload_size;
+}
+
+ResultOr<void> receive_message(Socket& socket, Vector<u8>& out_payload)
+{
+    u8 header[scan_message_header_size];
+    TRY(socket.receive_all(header));
+    TRY_ASSIGN(const u32 payload_size, decode_message_size(header));
+
+    out_payload.resize(payload_size);
+    TRY(socket.receive_all(out_payload));
+    return {};
+}
+
+} // namespace Octopus
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Socket.h"
+
+namespace Octopus
+{
+
+//
+// The binary protocol spoken between the scan server and the client stations.
+//
+// Every message is a frame that begins with its payload size, encoded as a 32-bit little-endian unsigned
+// integer. The first byte of the payload is the request type. A response echoes the request type, followed
+// by a status byte and, if the request failed, the result code. All integers are little-endian and strings
+// are prefixed by their length, encoded as a 16-bit unsigned integer.
+//
+
+enum class ScanRequestType : u8
+{
+    /// Payload: [String ticket_code]
+    /// Response: [u32 previous_scan_count] [String last_name] [String first_name] [u8 grade] [u8 grade_id]
+    ///           [String last_scan_date]
+    Scan = 1,
+
+    /// Payload: [String last_name] [String first_name]
+    /// Response: [u32 ticket_count] followed by ticket_count times [String ticket_code]
+    Find = 2,
+
+    /// Payload: [String last_name] [String first_name] [u8 grade] [u8 grade_id]
+    /// Response: [String ticket_code] [String last_name] [String first_name] [u8 grade] [u8 grade_id]
+    Emit = 3,
+
+    /// Payload: (void)
+    /// Response: (void)
+    Save = 4,
+
+    /// Payload: (void)
+    /// Response: [u32 last_minute_scan_count] [u32 last_quarter_hour_scan_count] [u32 station_count] followed by
+    ///           station_count times [u32 station_id] [u32 last_minute_scan_count] [u32 last_quarter_hour_scan_count]
+    Rate = 5,
+
+    /// Payload: [String last_name] [String first_name] [u8 max_match_count]
+    /// Response: [u32 match_count] followed by match_count times [String ticket_code] [String last_name]
+    ///           [String first_name] [u8 grade] [u8 grade_id] [u32 distance]
+    Search = 6,
+};
+
+enum class ScanResponseStatus : u8
+{
+    Success = 0,
+    /// The status is followed by [u8 result_code].
+    Failure = 1,
+};
+
+/// Frames larger than this are rejected, so a misbehaving peer can't make the other end allocate without bound.
+static constexpr u32 max_scan_message_size = 64 * 1024;
+
+class MessageWriter
+{
+public:
+    MessageWriter();
+
+    /// Discards everything that was written, while keeping the allocated memory.
+    void reset();
+
+    void write_u8(u8 value);
+    void write_u32(u32 value);
+    void write_u64(u64 value);
+    void write_string(StringView value);
+
+    /// Writes the size of the payload in front of it and returns the whole frame.
+    ResultOr<Span<const u8>> finish();
+
+private:
+    Vector<u8> m_buffer;
+};
+
+class MessageReader
+{
+public:
+    explicit MessageReader(Span<const u8> payload)
+        : m_payload(payload)
+    {
+    }
+
+    ResultOr<u8> read_u8();
+    ResultOr<u32> read_u32();
+    ResultOr<u64> read_u64();
+    ResultOr<String> read_string();
+
+    NODISCARD ALWAYS_INLINE bool is_at_end() const { return m_offset == m_payload.size(); }
+
+private:
+    ResultOr<Span<const u8>> read_bytes(usize byte_count);
+
+private:
+    Span<const u8> m_payload;
+    usize m_offset = 0;
+};
+
+/// Size of the prefix that stores the payload size, at the beginning of every frame.
+static constexpr usize scan_message_header_size = sizeof(u32);
+
+ResultOr<void> send_message(Socket& socket, MessageWriter& message);
+
+/// Checks whether the buffer begins with a whole frame. If it does, its payload is returned through the output
+/// parameter and the size of the whole frame is returned. Otherwise, zero is returned.
+ResultOr<usize> peek_message(Span<const u8> buffer, Span<const u8>& out_payload);
+
+/// Blocks until a whole frame was received and stores its payload in the given buffer.
+ResultOr<void> receive_message(Socket& socket, Vector<u8>& out_payload);
+
+} // namespace Octopus
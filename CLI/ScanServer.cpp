@@ -0,0 +1,640 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "ScanServer.h"
+#include "MathUtils.h"
+#include "Print.h"
+
+#include <cstring>
+#include <format>
+
+namespace Octopus
+{
+
+/// A connection never buffers more than one maximum sized request that wasn't received completely.
+static constexpr usize max_connection_input_size = scan_message_header_size + max_scan_message_size;
+
+/// Requests of a connection aren't handled anymore while it has more than this many bytes left to send.
+static constexpr usize max_connection_output_size = 256 * 1024;
+
+/// The windows over which the scan rates are reported.
+static constexpr usize rate_short_window_seconds = 60;
+static constexpr usize rate_long_window_seconds = 15 * 60;
+
+/// The durations of the requests are reported for every power of two between these bounds, in nanoseconds. A scan
+/// that is handled from memory takes about a microsecond, so the first bucket ends at 256 ns.
+static constexpr u32 metrics_first_bucket_bit = 8;
+static constexpr u32 metrics_last_bucket_bit = 36;
+
+/// While a save is running, the event loop checks this often whether it has finished.
+static constexpr i32 save_poll_timeout_milliseconds = 5;
+
+static constexpr StringView s_request_type_names[] = { "invalid", "scan", "find", "emit", "save", "rate", "search" };
+
+ResultOr<OwnPtr<ScanServer>>
+ScanServer::create(ShardedTable& table, String database_filepath, u16 port, const ScanServerOptions& options)
+{
+    TRY_ASSIGN(OwnPtr<Socket> listener, Socket::listen_on_localhost(port));
+    TRY(listener->set_non_blocking());
+
+    OwnPtr<ScanServer> server = OwnPtr<ScanServer>(
+        new ScanServer(table, std::move(database_filepath), std::move(listener), options.dashboard_interval_seconds)
+    );
+    if (!server)
+        return Result(Result::OutOfMemory);
+
+    if (options.metrics_port != 0)
+    {
+        TRY_ASSIGN(server->m_metrics_endpoint, MetricsEndpoint::create(options.metrics_port));
+    }
+
+    server->m_next_dashboard_time =
+        std::chrono::steady_clock::now() + std::chrono::seconds(server->m_dashboard_interval_seconds);
+    return server;
+}
+
+ScanServer::~ScanServer()
+{
+    if (m_save_worker.joinable())
+        m_save_worker.join();
+}
+
+void ScanServer::run()
+{
+    while (true)
+    {
+        m_poll_requests.clear();
+        SocketPollRequest listener_poll_request;
+        listener_poll_request.socket = m_listener.get();
+        listener_poll_request.wants_to_read = true;
+        m_poll_requests.push_back(listener_poll_request);
+
+        for (const auto& connection : m_connections)
+        {
+            SocketPollRequest poll_request;
+            poll_request.socket = connection->socket.get();
+            poll_request.wants_to_read = can_handle_requests(*connection);
+            poll_request.wants_to_write = connection->output_offset < connection->output_buffer.size();
+            m_poll_requests.push_back(poll_request);
+        }
+
+        const usize metrics_poll_request_offset = m_poll_requests.size();
+        if (m_metrics_endpoint)
+            m_metrics_endpoint->append_poll_requests(m_poll_requests);
+
+        auto result_or_void = Socket::poll(m_poll_requests, get_poll_timeout_milliseconds());
+        if (result_or_void.is_result())
+        {
+            const auto result_code = result_or_void.release_result().get_code();
+            Print::line("Failed to poll the stations, with result code: {}", static_cast<u32>(result_code));
+            Print::flush();
+            continue;
+        }
+
+        // NOTE: The first poll request always belongs to the listener. The others belong to the connections,
+        //       in the same order.
+        for (usize index = 0; index < m_connections.size(); ++index)
+        {
+            const SocketPollRequest& poll_request = m_poll_requests[index + 1];
+            Connection& connection = *m_connections[index];
+
+            if (poll_request.is_readable || poll_request.has_failed)
+                receive_requests(connection);
+
+            handle_received_requests(connection);
+
+            if (connection.output_offset < connection.output_buffer.size())
+                send_responses(connection);
+        }
+
+        update_save();
+
+        const usize connection_count = m_connections.size();
+        std::erase_if(m_connections, [](const OwnPtr<Connection>& connection) { return connection->is_closed; });
+        if (m_connections.size() != connection_count)
+        {
+            Print::line("{} station(s) disconnected.", connection_count - m_connections.size());
+            Print::flush();
+        }
+
+        if (m_poll_requests[0].is_readable)
+            accept_pending_connections();
+
+        if (m_metrics_endpoint)
+        {
+            m_metrics_endpoint->process_poll_results(Span<const SocketPollRequest>(m_poll_requests).subspan(
+                metrics_poll_request_offset
+            ));
+
+            // The metrics are only collected when a scraper asks for them.
+            if (m_metrics_endpoint->has_pending_requests())
+            {
+                m_metrics_text.clear();
+                write_metrics(m_metrics_text);
+                m_metrics_endpoint->send_responses(m_metrics_text);
+            }
+        }
+
+        if (m_dashboard_interval_seconds > 0 && std::chrono::steady_clock::now() >= m_next_dashboard_time)
+        {
+            print_dashboard();
+            const auto dashboard_interval = std::chrono::seconds(m_dashboard_interval_seconds);
+            m_next_dashboard_time = std::chrono::steady_clock::now() + dashboard_interval;
+        }
+    }
+}
+
+void ScanServer::write_metrics(String& output) const
+{
+    auto out = std::back_inserter(output);
+
+    output.append("# HELP octopus_requests_total Requests handled by the scan server.\n");
+    output.append("# TYPE octopus_requests_total counter\n");
+    for (usize request_type = 1; request_type < request_type_count; ++request_type)
+    {
+        const u64 request_count = m_request_metrics[request_type].latency.count();
+        std::format_to(
+            out, "octopus_requests_total{{type=\"{}\"}} {}\n", s_request_type_names[request_type], request_count
+        );
+    }
+
+    output.append("# HELP octopus_request_failures_total Requests that the scan server answered with an error.\n");
+    output.append("# TYPE octopus_request_failures_total counter\n");
+    for (usize request_type = 1; request_type < request_type_count; ++request_type)
+    {
+        const u64 failure_count = m_request_metrics[request_type].failure_count.load(std::memory_order_relaxed);
+        std::format_to(
+            out, "octopus_request_failures_total{{type=\"{}\"}} {}\n", s_request_type_names[request_type], failure_count
+        );
+    }
+
+    output.append("# HELP octopus_request_duration_seconds Time spent handling the requests of the stations.\n");
+    output.append("# TYPE octopus_request_duration_seconds histogram\n");
+    for (usize request_type = 1; request_type < request_type_count; ++request_type)
+    {
+        const StringView type_name = s_request_type_names[request_type];
+        const LatencyHistogram& latency = m_request_metrics[request_type].latency;
+
+        // NOTE: The count is read before the buckets, so that the buckets never exceed it while requests are being
+        //       recorded. Prometheus requires the buckets to be cumulative and bounded by the total count.
+        const u64 request_count = latency.count();
+        for (u32 bucket_bit = metrics_first_bucket_bit; bucket_bit <= metrics_last_bucket_bit; ++bucket_bit)
+        {
+            const u64 bucket_bound = static_cast<u64>(1) << bucket_bit;
+            const u64 bucket_count = std::min(latency.count_below(bucket_bound), request_count);
+            std::format_to(
+                out,
+                "octopus_request_duration_seconds_bucket{{type=\"{}\",le=\"{}\"}} {}\n",
+                type_name,
+                static_cast<double>(bucket_bound) / 1e9,
+                bucket_count
+            );
+        }
+
+        std::format_to(
+            out, "octopus_request_duration_seconds_bucket{{type=\"{}\",le=\"+Inf\"}} {}\n", type_name, request_count
+        );
+        std::format_to(
+            out,
+            "octopus_request_duration_seconds_sum{{type=\"{}\"}} {}\n",
+            type_name,
+            static_cast<double>(latency.sum_nanoseconds()) / 1e9
+        );
+        std::format_to(out, "octopus_request_duration_seconds_count{{type=\"{}\"}} {}\n", type_name, request_count);
+    }
+
+    output.append("# HELP octopus_scans_total Successful scans of all stations.\n");
+    output.append("# TYPE octopus_scans_total counter\n");
+    const u64 scan_count = m_request_metrics[static_cast<usize>(ScanRequestType::Scan)].latency.count() -
+                           m_request_metrics[static_cast<usize>(ScanRequestType::Scan)].failure_count.load();
+    std::format_to(out, "octopus_scans_total {}\n", scan_count);
+
+    output.append("# HELP octopus_table_entries Tickets in the database.\n");
+    output.append("# TYPE octopus_table_entries gauge\n");
+    auto result_or_entry_count = m_table.entry_count();
+    if (!result_or_entry_count.is_result())
+        std::format_to(out, "octopus_table_entries {}\n", result_or_entry_count.release_value());
+
+    output.append("# HELP octopus_connected_stations Stations that are currently connected.\n");
+    output.append("# TYPE octopus_connected_stations gauge\n");
+    std::format_to(out, "octopus_connected_stations {}\n", m_connections.size());
+}
+
+i32 ScanServer::get_poll_timeout_milliseconds() const
+{
+    // NOTE: The worker thread can't wake up the event loop, so it checks the save periodically while it runs.
+    const i32 save_timeout_milliseconds = m_is_save_running ? save_poll_timeout_milliseconds : INT32_MAX;
+    if (m_dashboard_interval_seconds == 0)
+        return m_is_save_running ? save_timeout_milliseconds : -1;
+
+    const auto remaining_time = m_next_dashboard_time - std::chrono::steady_clock::now();
+    const auto remaining_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(remaining_time).count();
+    return static_cast<i32>(std::clamp<i64>(remaining_milliseconds, 0, save_timeout_milliseconds));
+}
+
+void ScanServer::print_dashboard()
+{
+    const i64 now = static_cast<i64>(std::time(nullptr));
+
+    Print::line("---------------- Scan rates ----------------");
+    Print::line(
+        "All stations: {} in the last minute, {:.1f} per minute over the last 15 minutes.",
+        m_scan_rate.count_recent(now, rate_short_window_seconds),
+        static_cast<float>(m_scan_rate.count_recent(now, rate_long_window_seconds)) / 15.0f
+    );
+
+    Print::LocalIndent local_indent;
+    for (const auto& connection : m_connections)
+    {
+        Print::line(
+            "Station {}: {} in the last minute, {:.1f} per minute over the last 15 minutes.",
+            connection->station_id,
+            connection->scan_rate.count_recent(now, rate_short_window_seconds),
+            static_cast<float>(connection->scan_rate.count_recent(now, rate_long_window_seconds)) / 15.0f
+        );
+    }
+}
+
+void ScanServer::accept_pending_connections()
+{
+    while (true)
+    {
+        auto result_or_connection = m_listener->accept();
+        if (result_or_connection.is_result())
+        {
+            // A failed accept (for example, because the process ran out of descriptors) must not bring
+            // down the server, as the other stations are still connected.
+            const auto result_code = result_or_connection.release_result().get_code();
+            Print::line("Failed to accept a station, with result code: {}", static_cast<u32>(result_code));
+            Print::flush();
+            return;
+        }
+
+        OwnPtr<Socket> socket = result_or_connection.release_value();
+        if (!socket)
+            return;
+        if (socket->set_non_blocking().is_result())
+            continue;
+
+        OwnPtr<Connection> connection = std::make_unique<Connection>();
+        if (!connection)
+            return;
+
+        connection->socket = std::move(socket);
+        connection->input_buffer.resize(max_connection_input_size);
+        connection->station_id = m_next_station_id++;
+        const u32 station_id = connection->station_id;
+        m_connections.push_back(std::move(connection));
+
+        Print::line("Station {} has connected.", station_id);
+        Print::flush();
+    }
+}
+
+bool ScanServer::can_handle_requests(const Connection& connection)
+{
+    return !connection.is_closed && connection.save_state == SaveState::None &&
+           connection.output_buffer.size() - connection.output_offset <= max_connection_output_size;
+}
+
+void ScanServer::update_save()
+{
+    if (m_is_save_running && m_has_save_finished.load(std::memory_order_acquire))
+    {
+        m_save_worker.join();
+        m_is_save_running = false;
+        m_has_save_finished.store(false, std::memory_order_relaxed);
+
+        const auto finish_time = std::chrono::steady_clock::now();
+        RequestMetrics& request_metrics = m_request_metrics[static_cast<usize>(ScanRequestType::Save)];
+
+        for (const auto& connection : m_connections)
+        {
+            if (connection->save_state != SaveState::Running)
+                continue;
+            connection->save_state = SaveState::None;
+
+            const auto elapsed_time = finish_time - connection->save_request_time;
+            const auto elapsed_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed_time);
+            request_metrics.latency.record(static_cast<u64>(elapsed_nanoseconds.count()));
+
+            m_response.reset();
+            m_response.write_u8(static_cast<u8>(ScanRequestType::Save));
+            if (m_save_failure_code.has_value())
+            {
+                request_metrics.failure_count.fetch_add(1, std::memory_order_relaxed);
+                m_response.write_u8(static_cast<u8>(ScanResponseStatus::Failure));
+                m_response.write_u8(static_cast<u8>(*m_save_failure_code));
+            }
+            else
+            {
+                m_response.write_u8(static_cast<u8>(ScanResponseStatus::Success));
+            }
+
+            append_response(*connection, m_response);
+        }
+
+        if (m_save_failure_code.has_value())
+        {
+            Print::line("Failed to save the database, with result code: {}", static_cast<u32>(*m_save_failure_code));
+            Print::flush();
+        }
+    }
+
+    if (m_is_save_running || !m_is_save_queued)
+        return;
+
+    // The save takes a snapshot of the table when it starts, so it includes every request that was handled before
+    // any of the queued save requests.
+    for (const auto& connection : m_connections)
+    {
+        if (connection->save_state == SaveState::Queued)
+            connection->save_state = SaveState::Running;
+    }
+
+    m_is_save_queued = false;
+    m_is_save_running = true;
+    m_save_failure_code.reset();
+    m_save_worker = std::thread(
+        [this]
+        {
+            auto result_or_void = m_table.save_to_file(m_database_filepath);
+            if (result_or_void.is_result())
+                m_save_failure_code = result_or_void.release_result().get_code();
+            m_has_save_finished.store(true, std::memory_order_release);
+        }
+    );
+}
+
+void ScanServer::append_response(Connection& connection, MessageWriter& response)
+{
+    auto result_or_frame = response.finish();
+    if (result_or_frame.is_result())
+    {
+        connection.is_closed = true;
+        return;
+    }
+
+    const Span<const u8> response_frame = result_or_frame.release_value();
+    connection.output_buffer.insert(connection.output_buffer.end(), response_frame.begin(), response_frame.end());
+}
+
+void ScanServer::receive_requests(Connection& connection)
+{
+    while (!connection.is_closed && connection.input_size < connection.input_buffer.size())
+    {
+        const Span<u8> free_space = Span<u8>(connection.input_buffer).subspan(connection.input_size);
+        auto result_or_received_byte_count = connection.socket->receive_some(free_space);
+
+        if (result_or_received_byte_count.is_result())
+        {
+            connection.is_closed = true;
+            return;
+        }
+
+        const usize received_byte_count = result_or_received_byte_count.release_value();
+        if (received_byte_count == 0)
+            return;
+        connection.input_size += received_byte_count;
+    }
+}
+
+void ScanServer::handle_received_requests(Connection& connection)
+{
+    usize consumed_byte_count = 0;
+
+    while (can_handle_requests(connection))
+    {
+        const usize pending_byte_count = connection.input_size - consumed_byte_count;
+        const Span<const u8> pending_bytes =
+            Span<const u8>(connection.input_buffer.data() + consumed_byte_count, pending_byte_count);
+
+        Span<const u8> request_payload;
+        auto result_or_frame_size = peek_message(pending_bytes, request_payload);
+        if (result_or_frame_size.is_result())
+        {
+            // The station sent an invalid frame, so the stream can't be trusted anymore.
+            connection.is_closed = true;
+            break;
+        }
+
+        const usize frame_size = result_or_frame_size.release_value();
+        if (frame_size == 0)
+            break;
+        consumed_byte_count += frame_size;
+
+        MessageReader request(request_payload);
+        auto result_or_request_type = request.read_u8();
+        if (result_or_request_type.is_result())
+        {
+            connection.is_closed = true;
+            break;
+        }
+        const u8 request_type = result_or_request_type.release_value();
+
+        // The save is answered once the worker thread has written the file (see update_save).
+        if (request_type == static_cast<u8>(ScanRequestType::Save))
+        {
+            connection.save_state = SaveState::Queued;
+            connection.save_request_time = std::chrono::steady_clock::now();
+            m_is_save_queued = true;
+            continue;
+        }
+
+        m_response.reset();
+        m_response.write_u8(request_type);
+        m_response.write_u8(static_cast<u8>(ScanResponseStatus::Success));
+
+        const auto start_time = std::chrono::steady_clock::now();
+        auto result_or_void = handle_request(static_cast<ScanRequestType>(request_type), request, m_response);
+        const auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+        // NOTE: Unknown request types are still answered, but they aren't worth a metric of their own.
+        RequestMetrics* request_metrics = nullptr;
+        if (request_type > 0 && request_type < request_type_count)
+        {
+            request_metrics = &m_request_metrics[request_type];
+            const auto elapsed_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed_time);
+            request_metrics->latency.record(static_cast<u64>(elapsed_nanoseconds.count()));
+        }
+
+        if (result_or_void.is_result())
+        {
+            if (request_metrics)
+                request_metrics->failure_count.fetch_add(1, std::memory_order_relaxed);
+
+            // Discard anything the handler wrote before failing.
+            m_response.reset();
+            m_response.write_u8(request_type);
+            m_response.write_u8(static_cast<u8>(ScanResponseStatus::Failure));
+            m_response.write_u8(static_cast<u8>(result_or_void.release_result().get_code()));
+        }
+        else if (request_type == static_cast<u8>(ScanRequestType::Scan))
+        {
+            const i64 scan_timestamp = static_cast<i64>(std::time(nullptr));
+            connection.scan_rate.record(scan_timestamp);
+            m_scan_rate.record(scan_timestamp);
+        }
+
+        append_response(connection, m_response);
+    }
+
+    // Move the bytes of the requests that weren't received completely to the beginning of the buffer.
+    if (consumed_byte_count > 0)
+    {
+        std::memmove(
+            connection.input_buffer.data(),
+            connection.input_buffer.data() + consumed_byte_count,
+            connection.input_size - consumed_byte_count
+        );
+        connection.input_size -= consumed_byte_count;
+    }
+}
+
+void ScanServer::send_responses(Connection& connection)
+{
+    const Span<const u8> pending_bytes = Span<const u8>(connection.output_buffer).subspan(connection.output_offset);
+    auto result_or_sent_byte_count = connection.socket->send_some(pending_bytes);
+    if (result_or_sent_byte_count.is_result())
+    {
+        connection.is_closed = true;
+        return;
+    }
+
+    connection.output_offset += result_or_sent_byte_count.release_value();
+    if (connection.output_offset == connection.output_buffer.size())
+    {
+        connection.output_buffer.clear();
+        connection.output_offset = 0;
+    }
+}
+
+ResultOr<void>
+ScanServer::handle_request(ScanRequestType request_type, MessageReader& request, MessageWriter& response)
+{
+    switch (request_type)
+    {
+        case ScanRequestType::Scan: return handle_scan(request, response);
+        case ScanRequestType::Find: return handle_find(request, response);
+        case ScanRequestType::Emit: return handle_emit(request, response);
+        // NOTE: Saves are never handled here, as they run on the worker thread.
+        case ScanRequestType::Save: break;
+        case ScanRequestType::Rate: return handle_rate(request, response);
+        case ScanRequestType::Search: return handle_search(request, response);
+    }
+
+    return Result(Result::InvalidMessage);
+}
+
+ResultOr<void> ScanServer::handle_scan(MessageReader& request, MessageWriter& response)
+{
+    TRY_ASSIGN(const String ticket_code, request.read_string());
+    // NOTE: Mistyped codes are usually rejected by their check character, before the table is accessed.
+    TRY_ASSIGN(const TicketID ticket_id, m_table.parse_ticket_code(ticket_code));
+
+    TRY_ASSIGN(const TableEntry entry, m_table.scan_ticket(ticket_id));
+    TRY_ASSIGN(const String last_scan_date, format_scan_timestamp(entry.metadata.last_scan_timestamp));
+
+    // The response describes the ticket as it was before this scan.
+    response.write_u32(entry.metadata.scan_count.load());
+    response.write_string(entry.last_name);
+    response.write_string(entry.first_name);
+    response.write_u8(entry.grade);
+    response.write_u8(static_cast<u8>(entry.grade_id));
+    response.write_string(last_scan_date);
+    return {};
+}
+
+ResultOr<void> ScanServer::handle_find(MessageReader& request, MessageWriter& response)
+{
+    TRY_ASSIGN(String last_name, request.read_string());
+    TRY_ASSIGN(String first_name, request.read_string());
+    TRY(Table::format_name(last_name));
+    TRY(Table::format_name(first_name));
+
+    TRY_ASSIGN(const Vector<TicketID> ticket_ids, m_table.find_ticket_id_by_name(first_name, last_name));
+
+    TRY_ASSIGN(const u32 ticket_count, safe_truncate_unsigned<u32>(ticket_ids.size()));
+    response.write_u32(ticket_count);
+    for (const TicketID ticket_id : ticket_ids)
+        response.write_string(m_table.format_ticket_code(ticket_id));
+
+    return {};
+}
+
+ResultOr<void> ScanServer::handle_emit(MessageReader& request, MessageWriter& response)
+{
+    TableEntry entry;
+    TRY_ASSIGN(entry.last_name, request.read_string());
+    TRY_ASSIGN(entry.first_name, request.read_string());
+    TRY_ASSIGN(entry.grade, request.read_u8());
+    TRY_ASSIGN(const u8 grade_id, request.read_u8());
+    entry.grade_id = static_cast<char>(grade_id);
+
+    TRY_ASSIGN(const TicketID ticket_id, m_table.insert_entry(std::move(entry)));
+    TRY_ASSIGN(const TableEntry& inserted_entry, m_table.get_entry(ticket_id));
+
+    response.write_string(m_table.format_ticket_code(ticket_id));
+    response.write_string(inserted_entry.last_name);
+    response.write_string(inserted_entry.first_name);
+    response.write_u8(inserted_entry.grade);
+    response.write_u8(static_cast<u8>(inserted_entry.grade_id));
+    return {};
+}
+
+ResultOr<void> ScanServer::handle_rate(MessageReader& request, MessageWriter& response)
+{
+    (void)request;
+    const i64 now = static_cast<i64>(std::time(nullptr));
+
+    const auto write_scan_rate = [&](const ScanRateRecorder& scan_rate) -> ResultOr<void>
+    {
+        const u64 short_window_count = scan_rate.count_recent(now, rate_short_window_seconds);
+        const u64 long_window_count = scan_rate.count_recent(now, rate_long_window_seconds);
+        TRY_ASSIGN(const u32 truncated_short_window_count, safe_truncate_unsigned<u32>(short_window_count));
+        TRY_ASSIGN(const u32 truncated_long_window_count, safe_truncate_unsigned<u32>(long_window_count));
+        response.write_u32(truncated_short_window_count);
+        response.write_u32(truncated_long_window_count);
+        return {};
+    };
+
+    TRY(write_scan_rate(m_scan_rate));
+    TRY_ASSIGN(const u32 station_count, safe_truncate_unsigned<u32>(m_connections.size()));
+    response.write_u32(station_count);
+    for (const auto& connection : m_connections)
+    {
+        response.write_u32(connection->station_id);
+        TRY(write_scan_rate(connection->scan_rate));
+    }
+
+    return {};
+}
+
+ResultOr<void> ScanServer::handle_search(MessageReader& request, MessageWriter& response)
+{
+    TRY_ASSIGN(const String last_name, request.read_string());
+    TRY_ASSIGN(const String first_name, request.read_string());
+    TRY_ASSIGN(const u8 max_match_count, request.read_u8());
+
+    TRY_ASSIGN(
+        const Vector<TableNameMatch> matches,
+        m_table.find_similar_names(last_name, first_name, max_match_count)
+    );
+
+    response.write_u32(static_cast<u32>(matches.size()));
+    for (const TableNameMatch& match : matches)
+    {
+        response.write_string(m_table.format_ticket_code(match.ticket_id));
+        response.write_string(match.entry.last_name);
+        response.write_string(match.entry.first_name);
+        response.write_u8(match.entry.grade);
+        response.write_u8(static_cast<u8>(match.entry.grade_id));
+        response.write_u32(match.distance);
+    }
+
+    return {};
+}
+
+} // namespace Octopus
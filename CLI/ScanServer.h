@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "LatencyHistogram.h"
+#include "MetricsEndpoint.h"
+#include "Result.h"
+#include "ScanProtocol.h"
+#include "ScanRate.h"
+#include "ShardedTable.h"
+#include "Socket.h"
+
+#include <chrono>
+
+namespace Octopus
+{
+
+struct ScanServerOptions
+{
+    /// If not zero, the scan rates of all stations are printed every that many seconds.
+    u32 dashboard_interval_seconds = 0;
+    /// If not zero, the metrics of the server are served over HTTP on this port (see MetricsEndpoint).
+    u16 metrics_port = 0;
+};
+
+///
+/// Holds the table of a single process and serves the requests of multiple client stations, so that all
+/// gates share one consistent source of truth.
+///
+/// All connections are served by a single thread, using non-blocking sockets and an event loop. A station may
+/// pipeline requests: all the complete requests that were received are handled at once and their responses are
+/// sent back in a single batch. The memory used by every connection is bounded, as a station that doesn't read
+/// its responses stops having its requests handled until it catches up.
+///
+/// Saving the database is the only request that can take long, so the file is written on a worker thread, while
+/// the stations keep being served. A station that asked for a save has no other request handled until the
+/// save is answered, so that its responses are still sent in the order of its requests.
+///
+class ScanServer
+{
+public:
+    OCT_NONCOPYABLE(ScanServer)
+    OCT_NONMOVABLE(ScanServer)
+    ~ScanServer();
+
+public:
+    static ResultOr<OwnPtr<ScanServer>>
+    create(ShardedTable& table, String database_filepath, u16 port, const ScanServerOptions& options = {});
+
+    /// Accepts client stations and serves their requests. This function never returns.
+    void run();
+
+private:
+    enum class SaveState : u8
+    {
+        None,
+        /// The station asked for a save, which is started after the one that is running finishes.
+        Queued,
+        /// The station waits for the save that is running on the worker thread.
+        Running,
+    };
+
+    struct Connection
+    {
+        OwnPtr<Socket> socket;
+
+        /// The bytes that were received, but that weren't handled yet, are the first input_size bytes.
+        /// The buffer is allocated once, when the station connects, and never grows.
+        Vector<u8> input_buffer;
+        usize input_size = 0;
+
+        /// The responses that weren't sent yet, starting at the given offset.
+        Vector<u8> output_buffer;
+        usize output_offset = 0;
+
+        bool is_closed = false;
+
+        /// Identifies the station (gate) in the scan rate reports. Never reused while the server runs.
+        u32 station_id = 0;
+        ScanRateRecorder scan_rate;
+
+        SaveState save_state = SaveState::None;
+        std::chrono::steady_clock::time_point save_request_time;
+    };
+
+private:
+    struct RequestMetrics
+    {
+        std::atomic<u64> failure_count = 0;
+        /// Records the time spent handling every request, including the failed ones.
+        LatencyHistogram latency;
+    };
+
+    /// Indexed by the request type. The index zero isn't a valid request type and is never used.
+    static constexpr usize request_type_count = static_cast<usize>(ScanRequestType::Search) + 1;
+
+private:
+    ScanServer(ShardedTable& table, String database_filepath, OwnPtr<Socket> listener, u32 dashboard_interval_seconds)
+        : m_table(table)
+        , m_database_filepath(std::move(database_filepath))
+        , m_listener(std::move(listener))
+        , m_dashboard_interval_seconds(dashboard_interval_seconds)
+    {
+    }
+
+    void accept_pending_connections();
+    void receive_requests(Connection& connection);
+    void handle_received_requests(Connection& connection);
+    void send_responses(Connection& connection);
+    NODISCARD static bool can_handle_requests(const Connection& connection);
+
+    /// Answers the stations whose save has finished, and starts the queued save if no save is running.
+    void update_save();
+    void append_response(Connection& connection, MessageWriter& response);
+
+    /// Returns how long the event loop can wait for the stations before the dashboard must be printed again.
+    NODISCARD i32 get_poll_timeout_milliseconds() const;
+    void print_dashboard();
+    void write_metrics(String& output) const;
+
+    ResultOr<void> handle_request(ScanRequestType request_type, MessageReader& request, MessageWriter& response);
+    ResultOr<void> handle_scan(MessageReader& request, MessageWriter& response);
+    ResultOr<void> handle_find(MessageReader& request, MessageWriter& response);
+    ResultOr<void> handle_emit(MessageReader& request, MessageWriter& response);
+    ResultOr<void> handle_rate(MessageReader& request, MessageWriter& response);
+    ResultOr<void> handle_search(MessageReader& request, MessageWriter& response);
+
+private:
+    ShardedTable& m_table;
+    String m_database_filepath;
+    OwnPtr<Socket> m_listener;
+    Vector<OwnPtr<Connection>> m_connections;
+    u32 m_next_station_id = 1;
+
+    /// The scans of all stations, including the ones that already disconnected.
+    ScanRateRecorder m_scan_rate;
+    u32 m_dashboard_interval_seconds;
+    std::chrono::steady_clock::time_point m_next_dashboard_time;
+
+    OwnPtr<MetricsEndpoint> m_metrics_endpoint;
+    RequestMetrics m_request_metrics[request_type_count];
+    String m_metrics_text;
+
+    // These are reused across all iterations of the event loop, in order to avoid reallocating them.
+    Vector<SocketPollRequest> m_poll_requests;
+    MessageWriter m_response;
+
+    /// Only a single save runs at a time. The result is written by the worker thread before it signals that the
+    /// save has finished, and is only read by the event loop after that.
+    std::thread m_save_worker;
+    std::atomic<bool> m_has_save_finished = false;
+    Optional<Result::Code> m_save_failure_code;
+    bool m_is_save_running = false;
+    bool m_is_save_queued = false;
+};
+
+} // namespace Octopus
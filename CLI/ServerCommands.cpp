@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Command.h"
+#include "MathUtils.h"
+#include "Print.h"
+#include "ScanProtocol.h"
+#include "ScanServer.h"
+
+namespace Octopus
+{
+
+static ResultOr<u16> get_port_from_argument(i64 port)
+{
+    if (port <= 0 || port > UINT16_MAX)
+        return Result(Result::InvalidParameter);
+    return static_cast<u16>(port);
+}
+
+static ResultOr<u32> get_dashboard_interval_from_argument(i64 dashboard_interval_seconds)
+{
+    if (dashboard_interval_seconds < 0 || dashboard_interval_seconds > 24 * 60 * 60)
+        return Result(Result::InvalidParameter);
+    return static_cast<u32>(dashboard_interval_seconds);
+}
+
+static ResultOr<OwnPtr<ProgramContext>>
+serve_database(const PrimaryCommandContext& context, const ScanServerOptions& options = {})
+{
+    const String& database_filepath = context.arguments_string[0];
+    TRY_ASSIGN(const u16 port, get_port_from_argument(context.arguments_integer[0]));
+    TRY_ASSIGN(OwnPtr<ShardedTable> table, ShardedTable::create_from_file(database_filepath));
+
+    TRY_ASSIGN(OwnPtr<ScanServer> server, ScanServer::create(*table, database_filepath, port, options));
+    // The server never returns to the command loop, so its messages are flushed as soon as they are printed.
+    Print::set_synchronized(true);
+    Print::line("Serving the database '{}' on localhost:{}.", database_filepath, port);
+    if (options.metrics_port != 0)
+        Print::line("Serving the metrics on http://localhost:{}/metrics.", options.metrics_port);
+    server->run();
+
+    OwnPtr<ProgramContext> program_context = OwnPtr<ProgramContext>(new ProgramContext(nullptr, false));
+    if (!program_context)
+        return Result(Result::OutOfMemory);
+    return program_context;
+}
+
+PRIMARY_COMMAND_CALLBACK(primary_command_serve_database)
+{
+    return serve_database(context);
+}
+
+PRIMARY_COMMAND_CALLBACK(primary_command_serve_database_with_dashboard)
+{
+    ScanServerOptions options;
+    TRY_ASSIGN(options.dashboard_interval_seconds, get_dashboard_interval_from_argument(context.arguments_integer[1]));
+    if (options.dashboard_interval_seconds == 0)
+        return Result(Result::InvalidParameter);
+    return serve_database(context, options);
+}
+
+PRIMARY_COMMAND_CALLBACK(primary_command_serve_database_with_metrics)
+{
+    ScanServerOptions options;
+    TRY_ASSIGN(options.metrics_port, get_port_from_argument(context.arguments_integer[1]));
+    TRY_ASSIGN(options.dashboard_interval_seconds, get_dashboard_interval_from_argument(context.arguments_integer[2]));
+    return serve_database(context, options);
+}
+
+PRIMARY_COMMAND_CALLBACK(primary_command_connect_to_server)
+{
+    TRY_ASSIGN(const u16 port, get_port_from_argument(context.arguments_integer[0]));
+    TRY_ASSIGN(OwnPtr<Socket> connection, Socket::connect_to_localhost(port));
+
+    OwnPtr<ProgramContext> program_context = OwnPtr<ProgramContext>(new ProgramContext(nullptr, true));
+    if (!program_context)
+        return Result(Result::OutOfMemory);
+
+    program_context->set_server_connection(std::move(connection));
+    Print::line("Connected to the scan server on localhost:{}.", port);
+    return program_context;
+}
+
+/// Sends the request to the server and waits for its response. If the server reports that the request failed,
+/// its result code is returned. Otherwise, the returned reader is positioned at the beginning of the response data.
+static ResultOr<MessageReader> exchange_request(
+    const SubcommandContext& context,
+    ScanRequestType request_type,
+    MessageWriter& request,
+    Vector<u8>& out_response_payload
+)
+{
+    const auto& connection = context.program_context->server_connection();
+    if (!connection)
+        return Result(Result::UnknownError);
+
+    TRY(send_message(*connection, request));
+    TRY(receive_message(*connection, out_response_payload));
+
+    MessageReader response(out_response_payload);
+    TRY_ASSIGN(const u8 response_type, response.read_u8());
+    if (response_type != static_cast<u8>(request_type))
+        return Result(Result::InvalidMessage);
+
+    TRY_ASSIGN(const u8 status, response.read_u8());
+    if (status == static_cast<u8>(ScanResponseStatus::Failure))
+    {
+        TRY_ASSIGN(const u8 result_code, response.read_u8());
+        return Result(static_cast<Result::Code>(result_code));
+    }
+
+    return response;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_remote_scan)
+{
+    const String& ticket_id_string = context.arguments_string[0];
+
+    MessageWriter request;
+    request.write_u8(static_cast<u8>(ScanRequestType::Scan));
+    request.write_string(ticket_id_string);
+
+    Vector<u8> response_payload;
+    auto result_or_response = exchange_request(context, ScanRequestType::Scan, request, response_payload);
+    if (result_or_response.is_result())
+    {
+        auto result_id = result_or_response.release_result().get_code();
+        if (result_id == Result::IdNotFound || result_id == Result::IdInvalid || result_id == Result::InvalidParameter)
+        {
+            Print::line("Ticket ID '{}' is not valid.", ticket_id_string);
+            return IterationDecision::Continue;
+        }
+
+        return Result(result_id);
+    }
+
+    MessageReader response = result_or_response.release_value();
+    TRY_ASSIGN(const u32 scan_count, response.read_u32());
+    TRY_ASSIGN(const String last_name, response.read_string());
+    TRY_ASSIGN(const String first_name, response.read_string());
+    TRY_ASSIGN(const u8 grade, response.read_u8());
+    TRY_ASSIGN(const u8 grade_id, response.read_u8());
+    TRY_ASSIGN(const String last_scan_date, response.read_string());
+
+    if (scan_count == 0)
+    {
+        Print::line("Ticket ID '{}' was never scanned before.", ticket_id_string);
+        Print::push_indentation();
+        Print::line("Name:  {} {}", last_name, first_name);
+        Print::line("Grade: {}{}", static_cast<u32>(grade), static_cast<char>(grade_id));
+        Print::pop_indentation();
+    }
+    else
+    {
+        Print::line("Ticket ID '{}' was scanned {} times.", ticket_id_string, scan_count);
+        Print::push_indentation();
+        Print::line("Name:           {} {}", last_name, first_name);
+        Print::line("Grade:          {}{}", static_cast<u32>(grade), static_cast<char>(grade_id));
+        Print::line("Last scan date: {}", last_scan_date);
+        Print::pop_indentation();
+    }
+
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_remote_find)
+{
+    MessageWriter request;
+    request.write_u8(static_cast<u8>(ScanRequestType::Find));
+    request.write_string(context.arguments_string[0]);
+    request.write_string(context.arguments_string[1]);
+
+    Vector<u8> response_payload;
+    TRY_ASSIGN(MessageReader response, exchange_request(context, ScanRequestType::Find, request, response_payload));
+    TRY_ASSIGN(const u32 ticket_count, response.read_u32());
+
+    if (ticket_count == 0)
+    {
+        Print::line("No ticket was emitted for this name.");
+        return IterationDecision::Continue;
+    }
+
+    Print::line("The following tickets were emitted for this name:");
+    Print::LocalIndent local_indent;
+    for (u32 index = 0; index < ticket_count; ++index)
+    {
+        TRY_ASSIGN(const String ticket_code, response.read_string());
+        Print::line("{}", ticket_code);
+    }
+
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_remote_search)
+{
+    MessageWriter request;
+    request.write_u8(static_cast<u8>(ScanRequestType::Search));
+    request.write_string(context.arguments_string[0]);
+    request.write_string(context.arguments_string[1]);
+    request.write_u8(static_cast<u8>(default_similar_name_match_count));
+
+    Vector<u8> response_payload;
+    TRY_ASSIGN(MessageReader response, exchange_request(context, ScanRequestType::Search, request, response_payload));
+    TRY_ASSIGN(const u32 match_count, response.read_u32());
+
+    if (match_count == 0)
+    {
+        Print::line("No ticket was emitted for a similar name.");
+        return IterationDecision::Continue;
+    }
+
+    Print::line("The following tickets were emitted for similar names:");
+    Print::LocalIndent local_indent;
+    for (u32 index = 0; index < match_count; ++index)
+    {
+        TRY_ASSIGN(const String ticket_code, response.read_string());
+        TRY_ASSIGN(const String last_name, response.read_string());
+        TRY_ASSIGN(const String first_name, response.read_string());
+        TRY_ASSIGN(const u8 grade, response.read_u8());
+        TRY_ASSIGN(const u8 grade_id, response.read_u8());
+        TRY_ASSIGN(const u32 distance, response.read_u32());
+        Print::line(
+            "{}: {} {} ({}{}, {} edits away)",
+            ticket_code,
+            last_name,
+            first_name,
+            static_cast<u32>(grade),
+            static_cast<char>(grade_id),
+            distance
+        );
+    }
+
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_remote_emit)
+{
+    const i64 grade = context.arguments_integer[0];
+    if (grade < 0)
+        return Result(Result::InvalidParameter);
+    if (context.arguments_string[2].size() != 1)
+        return Result(Result::InvalidParameter);
+
+    MessageWriter request;
+    request.write_u8(static_cast<u8>(ScanRequestType::Emit));
+    request.write_string(context.arguments_string[0]);
+    request.write_string(context.arguments_string[1]);
+    TRY_ASSIGN(const u8 truncated_grade, safe_truncate_unsigned<u8>(static_cast<u64>(grade)));
+    request.write_u8(truncated_grade);
+    request.write_u8(static_cast<u8>(context.arguments_string[2].back()));
+
+    Vector<u8> response_payload;
+    TRY_ASSIGN(MessageReader response, exchange_request(context, ScanRequestType::Emit, request, response_payload));
+    TRY_ASSIGN(const String ticket_code, response.read_string());
+    TRY_ASSIGN(const String last_name, response.read_string());
+    TRY_ASSIGN(const String first_name, response.read_string());
+    TRY_ASSIGN(const u8 emitted_grade, response.read_u8());
+    TRY_ASSIGN(const u8 emitted_grade_id, response.read_u8());
+
+    Print::line("The following ticket was emitted:");
+    Print::push_indentation();
+
+    Print::line("ID:         {}", ticket_code);
+    Print::line("First name: {}", first_name);
+    Print::line("Last name:  {}", last_name);
+    Print::line("Grade:      {}{}", static_cast<u32>(emitted_grade), static_cast<char>(emitted_grade_id));
+
+    Print::pop_indentation();
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_remote_save)
+{
+    MessageWriter request;
+    request.write_u8(static_cast<u8>(ScanRequestType::Save));
+
+    Vector<u8> response_payload;
+    TRY(exchange_request(context, ScanRequestType::Save, request, response_payload));
+    Print::line("The server has saved the database.");
+    return IterationDecision::Continue;
+}
+
+SUBCOMMAND_CALLBACK(subcommand_remote_rate)
+{
+    MessageWriter request;
+    request.write_u8(static_cast<u8>(ScanRequestType::Rate));
+
+    Vector<u8> response_payload;
+    TRY_ASSIGN(MessageReader response, exchange_request(context, ScanRequestType::Rate, request, response_payload));
+    TRY_ASSIGN(const u32 last_minute_count, response.read_u32());
+    TRY_ASSIGN(const u32 last_quarter_hour_count, response.read_u32());
+    TRY_ASSIGN(const u32 station_count, response.read_u32());
+
+    Print::line(
+        "All stations: {} in the last minute, {:.1f} per minute over the last 15 minutes.",
+        last_minute_count,
+        static_cast<float>(last_quarter_hour_count) / 15.0f
+    );
+
+    Print::LocalIndent local_indent;
+    for (u32 index = 0; index < station_count; ++index)
+    {
+        TRY_ASSIGN(const u32 station_id, response.read_u32());
+        TRY_ASSIGN(const u32 station_last_minute_count, response.read_u32());
+        TRY_ASSIGN(const u32 station_last_quarter_hour_count, response.read_u32());
+        Print::line(
+            "Station {}: {} in the last minute, {:.1f} per minute over the last 15 minutes.",
+            station_id,
+            station_last_minute_count,
+            static_cast<float>(station_last_quarter_hour_count) / 15.0f
+        );
+    }
+
+    return IterationDecision::Continue;
+}
+
+// NOTE: clang-format doesn't handle initializer lists very well, so we disable it while
+// defining the primary commands. It makes the code a lot easier to read.
+// clang-format off
+// NOLINTBEGIN
+
+static PrimaryCommandRegister s_serve_database_command(
+    "serve_database", { "serve" },
+    {
+        { CommandSyntax::Type::String, "database_filepath" },
+        { CommandSyntax::Type::Integer, "port" }
+    },
+    {},
+    primary_command_serve_database,
+    "Opens a database from a file and serves it to the client stations on localhost."
+);
+
+static PrimaryCommandRegister s_serve_database_with_dashboard_command(
+    "serve_database_with_dashboard", { "serve" },
+    {
+        { CommandSyntax::Type::String, "database_filepath" },
+        { CommandSyntax::Type::Integer, "port" },
+        { CommandSyntax::Type::Integer, "dashboard_interval_seconds" }
+    },
+    {},
+    primary_command_serve_database_with_dashboard,
+    "Serves a database like 'serve_database' and periodically prints the scan rate of every station."
+);
+
+static PrimaryCommandRegister s_serve_database_with_metrics_command(
+    "serve_database_with_metrics", { "serve" },
+    {
+        { CommandSyntax::Type::String, "database_filepath" },
+        { CommandSyntax::Type::Integer, "port" },
+        { CommandSyntax::Type::Integer, "metrics_port" },
+        { CommandSyntax::Type::Integer, "dashboard_interval_seconds" }
+    },
+    {},
+    primary_command_serve_database_with_metrics,
+    "Serves a database and exposes its metrics over HTTP. A dashboard interval of 0 disables the dashboard."
+);
+
+static PrimaryCommandRegister s_connect_to_server_command(
+    "connect_to_server", { "connect" },
+    {
+        { CommandSyntax::Type::Integer, "port" }
+    },
+    { "remote_scan", "remote_find", "remote_search", "remote_emit", "remote_save", "remote_rate" },
+    primary_command_connect_to_server,
+    "Connects to a scan server running on localhost."
+);
+
+static SubcommandRegister s_remote_scan_subcommand(
+    "remote_scan", { "scan", "s" },
+    {
+        { CommandSyntax::Type::String, "ticket_id" }
+    },
+    subcommand_remote_scan,
+    "Scans a ticket ID on the server."
+);
+
+static SubcommandRegister s_remote_find_subcommand(
+    "remote_find", { "find" },
+    {
+        { CommandSyntax::Type::String, "last_name" },
+        { CommandSyntax::Type::String, "first_name" }
+    },
+    subcommand_remote_find,
+    "Finds the ticket IDs emitted for the given name on the server."
+);
+
+static SubcommandRegister s_remote_search_subcommand(
+    "remote_search", { "search" },
+    {
+        { CommandSyntax::Type::String, "last_name" },
+        { CommandSyntax::Type::String, "first_name" }
+    },
+    subcommand_remote_search,
+    "Finds the tickets emitted on the server for the names closest to the given, possibly misspelled, name."
+);
+
+static SubcommandRegister s_remote_emit_subcommand(
+    "remote_emit", { "emit", "e" },
+    {
+        { CommandSyntax::Type::String, "last_name" },
+        { CommandSyntax::Type::String, "first_name" },
+        { CommandSyntax::Type::Integer, "grade" },
+        { CommandSyntax::Type::String, "grade_id" }
+    },
+    subcommand_remote_emit,
+    "Emits a new ticket on the server."
+);
+
+static SubcommandRegister s_remote_save_subcommand(
+    "remote_save", { "save" },
+    {},
+    subcommand_remote_save,
+    "Makes the server save the database to its file."
+);
+
+static SubcommandRegister s_remote_rate_subcommand(
+    "remote_rate", { "rate" },
+    {},
+    subcommand_remote_rate,
+    "Prints the scan rate of all stations connected to the server."
+);
+
+// NOLINTEND
+// clang-format on
+
+} // namespace Octopus
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Socket.h"
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <WinSock2.h>
+#else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace Octopus
+{
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+static constexpr NativeSocket invalid_native_socket = INVALID_SOCKET;
+static constexpr int send_flags = 0;
+
+ALWAYS_INLINE static void close_native_socket(NativeSocket native_socket)
+{
+    closesocket(native_socket);
+}
+
+ALWAYS_INLINE static bool last_operation_would_block()
+{
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+#else
+using NativeSocket = int;
+static constexpr NativeSocket invalid_native_socket = -1;
+static constexpr int send_flags = MSG_NOSIGNAL;
+
+ALWAYS_INLINE static void close_native_socket(NativeSocket native_socket)
+{
+    close(native_socket);
+}
+
+ALWAYS_INLINE static bool last_operation_would_block()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+#endif
+
+static ResultOr<void> initialize_socket_library()
+{
+#ifdef _WIN32
+    static bool s_is_initialized = false;
+    if (!s_is_initialized)
+    {
+        WSADATA wsa_data;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+            return Result(Result::NetworkError);
+        s_is_initialized = true;
+    }
+#endif
+
+    return {};
+}
+
+static sockaddr_in get_localhost_address(u16 port)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+static void disable_nagle_algorithm(NativeSocket native_socket)
+{
+    // The requests and responses are tiny, so they must not be delayed in order to be coalesced.
+    int option_value = 1;
+    setsockopt(
+        native_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&option_value), sizeof(option_value)
+    );
+}
+
+Socket::~Socket()
+{
+    close_native_socket(static_cast<NativeSocket>(m_handle));
+}
+
+ResultOr<OwnPtr<Socket>> Socket::listen_on_localhost(u16 port)
+{
+    TRY(initialize_socket_library());
+
+    const NativeSocket native_socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (native_socket == invalid_native_socket)
+        return Result(Result::NetworkError);
+
+    OwnPtr<Socket> listener = OwnPtr<Socket>(new Socket(static_cast<uintptr>(native_socket)));
+    if (!listener)
+    {
+        close_native_socket(native_socket);
+        return Result(Result::OutOfMemory);
+    }
+
+    int option_value = 1;
+    setsockopt(
+        native_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&option_value), sizeof(option_value)
+    );
+
+    const sockaddr_in address = get_localhost_address(port);
+    if (::bind(native_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        return Result(Result::NetworkError);
+    if (::listen(native_socket, SOMAXCONN) != 0)
+        return Result(Result::NetworkError);
+
+    return listener;
+}
+
+ResultOr<OwnPtr<Socket>> Socket::connect_to_localhost(u16 port)
+{
+    TRY(initialize_socket_library());
+
+    const NativeSocket native_socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (native_socket == invalid_native_socket)
+        return Result(Result::NetworkError);
+
+    OwnPtr<Socket> connection = OwnPtr<Socket>(new Socket(static_cast<uintptr>(native_socket)));
+    if (!connection)
+    {
+        close_native_socket(native_socket);
+        return Result(Result::OutOfMemory);
+    }
+
+    const sockaddr_in address = get_localhost_address(port);
+    if (::connect(native_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        return Result(Result::NetworkError);
+
+    disable_nagle_algorithm(native_socket);
+    return connection;
+}
+
+ResultOr<void> Socket::poll(Span<SocketPollRequest> requests, i32 timeout_milliseconds)
+{
+#ifdef _WIN32
+    using NativePollDescriptor = WSAPOLLFD;
+#else
+    using NativePollDescriptor = pollfd;
+#endif
+
+    // The descriptors are kept between calls, so that polling doesn't allocate in the steady state.
+    static Vector<NativePollDescriptor> s_descriptors;
+    s_descriptors.resize(requests.size());
+
+    for (usize index = 0; index < requests.size(); ++index)
+    {
+        const SocketPollRequest& request = requests[index];
+        s_descriptors[index] = {};
+        s_descriptors[index].fd = static_cast<NativeSocket>(request.socket->m_handle);
+        const int events = (request.wants_to_read ? POLLIN : 0) | (request.wants_to_write ? POLLOUT : 0);
+        s_descriptors[index].events = static_cast<short>(events);
+    }
+
+#ifdef _WIN32
+    const int ready_count =
+        WSAPoll(s_descriptors.data(), static_cast<ULONG>(s_descriptors.size()), timeout_milliseconds);
+#else
+    const int ready_count = ::poll(s_descriptors.data(), s_descriptors.size(), timeout_milliseconds);
+#endif
+    if (ready_count < 0)
+        return Result(Result::NetworkError);
+
+    for (usize index = 0; index < requests.size(); ++index)
+    {
+        const short returned_events = s_descriptors[index].revents;
+        requests[index].is_readable = (returned_events & POLLIN) != 0;
+        requests[index].is_writable = (returned_events & POLLOUT) != 0;
+        requests[index].has_failed = (returned_events & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+    }
+
+    return {};
+}
+
+ResultOr<OwnPtr<Socket>> Socket::accept()
+{
+    const NativeSocket native_socket = ::accept(static_cast<NativeSocket>(m_handle), nullptr, nullptr);
+    if (native_socket == invalid_native_socket)
+    {
+        if (last_operation_would_block())
+            return OwnPtr<Socket>();
+        return Result(Result::NetworkError);
+    }
+
+    OwnPtr<Socket> connection = OwnPtr<Socket>(new Socket(static_cast<uintptr>(native_socket)));
+    if (!connection)
+    {
+        close_native_socket(native_socket);
+        return Result(Result::OutOfMemory);
+    }
+
+    disable_nagle_algorithm(native_socket);
+    return connection;
+}
+
+ResultOr<void> Socket::set_non_blocking()
+{
+#ifdef _WIN32
+    u_long is_non_blocking = 1;
+    if (ioctlsocket(static_cast<NativeSocket>(m_handle), FIONBIO, &is_non_blocking) != 0)
+        return Result(Result::NetworkError);
+#else
+    const int flags = fcntl(static_cast<NativeSocket>(m_handle), F_GETFL, 0);
+    if (flags < 0 || fcntl(static_cast<NativeSocket>(m_handle), F_SETFL, flags | O_NONBLOCK) != 0)
+        return Result(Result::NetworkError);
+#endif
+
+    return {};
+}
+
+ResultOr<void> Socket::send_all(Span<const u8> buffer)
+{
+    usize sent_byte_count = 0;
+    while (sent_byte_count < buffer.size())
+    {
+        const int chunk_size = static_cast<int>(std::min<usize>(buffer.size() - sent_byte_count, INT32_MAX));
+        const auto* chunk = reinterpret_cast<const char*>(buffer.data() + sent_byte_count);
+
+        const auto result = ::send(static_cast<NativeSocket>(m_handle), chunk, chunk_size, send_flags);
+        if (result <= 0)
+            return Result(Result::NetworkError);
+        sent_byte_count += static_cast<usize>(result);
+    }
+
+    return {};
+}
+
+ResultOr<void> Socket::receive_all(Span<u8> buffer)
+{
+    usize received_byte_count = 0;
+    while (received_byte_count < buffer.size())
+    {
+        const int chunk_size = static_cast<int>(std::min<usize>(buffer.size() - received_byte_count, INT32_MAX));
+        auto* chunk = reinterpret_cast<char*>(buffer.data() + received_byte_count);
+
+        const auto result = ::recv(static_cast<NativeSocket>(m_handle), chunk, chunk_size, 0);
+        if (result == 0)
+            return Result(Result::ConnectionClosed);
+        if (result < 0)
+            return Result(Result::NetworkError);
+        received_byte_count += static_cast<usize>(result);
+    }
+
+    return {};
+}
+
+ResultOr<usize> Socket::send_some(Span<const u8> buffer)
+{
+    const int chunk_size = static_cast<int>(std::min<usize>(buffer.size(), INT32_MAX));
+    const auto* chunk = reinterpret_cast<const char*>(buffer.data());
+
+    const auto result = ::send(static_cast<NativeSocket>(m_handle), chunk, chunk_size, send_flags);
+    if (result < 0)
+    {
+        if (last_operation_would_block())
+            return 0;
+        return Result(Result::NetworkError);
+    }
+
+    return static_cast<usize>(result);
+}
+
+ResultOr<usize> Socket::receive_some(Span<u8> buffer)
+{
+    const int chunk_size = static_cast<int>(std::min<usize>(buffer.size(), INT32_MAX));
+    auto* chunk = reinterpret_cast<char*>(buffer.data());
+
+    const auto result = ::recv(static_cast<NativeSocket>(m_handle), chunk, chunk_size, 0);
+    if (result == 0)
+        return Result(Result::ConnectionClosed);
+    if (result < 0)
+    {
+        if (last_operation_would_block())
+            return 0;
+        return Result(Result::NetworkError);
+    }
+
+    return static_cast<usize>(result);
+}
+
+} // namespace Octopus
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+
+namespace Octopus
+{
+
+class Socket;
+
+struct SocketPollRequest
+{
+    Socket* socket = nullptr;
+    bool wants_to_read = false;
+    bool wants_to_write = false;
+
+    /// Filled by Socket::poll().
+    bool is_readable = false;
+    bool is_writable = false;
+    bool has_failed = false;
+};
+
+///
+/// A blocking TCP socket that is bound to the loopback interface. Only the operations required by the
+/// scan server and its clients are exposed.
+///
+class Socket
+{
+public:
+    OCT_NONCOPYABLE(Socket)
+    OCT_NONMOVABLE(Socket)
+    ~Socket();
+
+public:
+    static ResultOr<OwnPtr<Socket>> listen_on_localhost(u16 port);
+    static ResultOr<OwnPtr<Socket>> connect_to_localhost(u16 port);
+
+    /// Waits until at least one of the sockets is ready, or until the timeout expires. A negative timeout
+    /// waits indefinitely.
+    static ResultOr<void> poll(Span<SocketPollRequest> requests, i32 timeout_milliseconds);
+
+    /// If the socket is non-blocking and there is no pending connection, a null socket is returned.
+    ResultOr<OwnPtr<Socket>> accept();
+
+    ResultOr<void> set_non_blocking();
+
+    /// Blocks until the whole buffer was sent.
+    ResultOr<void> send_all(Span<const u8> buffer);
+
+    /// Blocks until the whole buffer was filled. Fails with ConnectionClosed if the peer closes the
+    /// connection before that.
+    ResultOr<void> receive_all(Span<u8> buffer);
+
+    /// Sends as much of the buffer as possible without blocking and returns the number of bytes sent.
+    ResultOr<usize> send_some(Span<const u8> buffer);
+
+    /// Receives as many bytes as are available without blocking and returns their count. Fails with
+    /// ConnectionClosed if the peer has closed the connection.
+    ResultOr<usize> receive_some(Span<u8> buffer);
+
+private:
+    explicit Socket(uintptr handle)
+        : m_handle(handle)
+    {
+    }
+
+private:
+    uintptr m_handle;
+};
+
+} // namespace Octopus
@@ -167,14 +167,14 @@ private:
 };
 
 static ResultOr<void>
-register_tickets_for_grade(const OwnPtr<Table>& table, TicketAtlas& atlas, u8 grade, char grade_id)
+register_tickets_for_grade(const TableSnapshot& table_snapshot, TicketAtlas& atlas, u8 grade, char grade_id)
 {
-    TRY(table->iterate_over_entries(
+    TRY(table_snapshot.iterate_over_entries(
         [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
         {
             if (entry.grade == grade && entry.grade_id == grade_id)
             {
-                auto ticket_id_string = transform_to_base_36(ticket_id);
+                auto ticket_id_string = table_snapshot.format_ticket_code(ticket_id);
                 for (i32 index = ticket_id_string.length() - 1; index >= 0; --index)
                 {
                     if (index != 0)
@@ -203,10 +203,11 @@ PRIMARY_COMMAND_CALLBACK(primary_command_write_tickets)
     TRY_ASSIGN(g_ticket_id_font, Font::create_from_ttf("MartianMono-Regular.ttf", 70.0F, { 0, 0, 0 }));
 
     TicketAtlas atlas = TicketAtlas(ticket_bitmap, 4, 2);
+    const TableSnapshot table_snapshot = table->snapshot();
 
     for (u8 grade = 9; grade <= 12; ++grade)
         for (char grade_id = 'A'; grade_id <= 'F'; ++grade_id)
-            TRY(register_tickets_for_grade(table, atlas, grade, grade_id));
+            TRY(register_tickets_for_grade(table_snapshot, atlas, grade, grade_id));
 
     TRY(atlas.generate());
 
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "BlockCompression.h"
+
+#include <cstring>
+
+namespace Octopus
+{
+
+ResultOr<BlockCompression> parse_block_compression(StringView compression_name)
+{
+    if (compression_name == "none")
+        return BlockCompression::None;
+    if (compression_name == "lz4")
+        return BlockCompression::LZ4;
+    return Result(Result::InvalidParameter);
+}
+
+StringView get_block_compression_name(BlockCompression compression)
+{
+    switch (compression)
+    {
+        case BlockCompression::None: return "none";
+        case BlockCompression::LZ4: return "lz4";
+    }
+    return "unknown";
+}
+
+// NOTE: The constants of the LZ4 block format. The last 5 bytes of a block are always literals, and the last match
+//       must begin at least 12 bytes before the end of the block, so decoders can copy in words near the end.
+static constexpr usize lz4_min_match_size = 4;
+static constexpr usize lz4_last_literals_size = 5;
+static constexpr usize lz4_match_find_limit = 12;
+static constexpr usize lz4_max_offset = 65535;
+static constexpr u8 lz4_run_mask = 15;
+
+static constexpr usize lz4_hash_bit_count = 12;
+static constexpr u32 lz4_no_position = UINT32_MAX;
+
+NODISCARD ALWAYS_INLINE static u32 read_u32(const char* bytes)
+{
+    u32 value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+NODISCARD ALWAYS_INLINE static u32 hash_lz4_sequence(u32 sequence)
+{
+    return (sequence * 2654435761U) >> (32 - lz4_hash_bit_count);
+}
+
+/// Lengths that don't fit in the 4 bits of the token continue in bytes of 255, ended by a smaller byte.
+static void append_lz4_length(String& out, usize length)
+{
+    while (length >= 255)
+    {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+static void append_lz4_sequence(String& out, StringView literals, usize match_offset, usize match_size)
+{
+    const usize extra_match_size = match_size - lz4_min_match_size;
+    const u8 literals_nibble = static_cast<u8>(std::min<usize>(literals.size(), lz4_run_mask));
+    const u8 match_nibble = static_cast<u8>(std::min<usize>(extra_match_size, lz4_run_mask));
+    out.push_back(static_cast<char>((literals_nibble << 4) | match_nibble));
+
+    if (literals_nibble == lz4_run_mask)
+        append_lz4_length(out, literals.size() - lz4_run_mask);
+    out.append(literals);
+
+    out.push_back(static_cast<char>(match_offset & 0xFF));
+    out.push_back(static_cast<char>(match_offset >> 8));
+    if (match_nibble == lz4_run_mask)
+        append_lz4_length(out, extra_match_size - lz4_run_mask);
+}
+
+static void append_lz4_last_literals(String& out, StringView literals)
+{
+    const u8 literals_nibble = static_cast<u8>(std::min<usize>(literals.size(), lz4_run_mask));
+    out.push_back(static_cast<char>(literals_nibble << 4));
+    if (literals_nibble == lz4_run_mask)
+        append_lz4_length(out, literals.size() - lz4_run_mask);
+    out.append(literals);
+}
+
+/// Greedy compressor that remembers the last position of every hashed 4-byte sequence, like the fast mode of the
+/// reference implementation. The output can be decompressed by any LZ4 block decoder.
+static void compress_lz4_block(StringView block, String& out)
+{
+    const char* bytes = block.data();
+    const usize size = block.size();
+
+    usize anchor = 0;
+    if (size > lz4_match_find_limit)
+    {
+        Vector<u32> positions(static_cast<usize>(1) << lz4_hash_bit_count, lz4_no_position);
+        const usize match_find_end = size - lz4_match_find_limit;
+        const usize match_end_limit = size - lz4_last_literals_size;
+
+        usize position = 0;
+        while (position < match_find_end)
+        {
+            const u32 sequence = read_u32(bytes + position);
+            u32& candidate_slot = positions[hash_lz4_sequence(sequence)];
+            const u32 candidate = candidate_slot;
+            candidate_slot = static_cast<u32>(position);
+
+            if (candidate == lz4_no_position || position - candidate > lz4_max_offset ||
+                read_u32(bytes + candidate) != sequence)
+            {
+                ++position;
+                continue;
+            }
+
+            usize match_size = lz4_min_match_size;
+            while (position + match_size < match_end_limit &&
+                   bytes[candidate + match_size] == bytes[position + match_size])
+                ++match_size;
+
+            append_lz4_sequence(out, block.substr(anchor, position - anchor), position - candidate, match_size);
+            position += match_size;
+            anchor = position;
+        }
+    }
+
+    append_lz4_last_literals(out, block.substr(anchor));
+}
+
+static ResultOr<void> decompress_lz4_block(StringView compressed_block, Span<char> out)
+{
+    const u8* input = reinterpret_cast<const u8*>(compressed_block.data());
+    const usize input_size = compressed_block.size();
+    usize input_offset = 0;
+    usize output_offset = 0;
+
+    const auto read_length = [&](usize& length) -> ResultOr<void>
+    {
+        u8 length_byte;
+        do
+        {
+            if (input_offset == input_size)
+                return Result(Result::CorruptedTable);
+            length_byte = input[input_offset++];
+            length += length_byte;
+        } while (length_byte == 255);
+        return {};
+    };
+
+    while (true)
+    {
+        if (input_offset == input_size)
+            return Result(Result::CorruptedTable);
+        const u8 token = input[input_offset++];
+
+        usize literals_size = token >> 4;
+        if (literals_size == lz4_run_mask)
+            TRY(read_length(literals_size));
+        if (literals_size > input_size - input_offset || literals_size > out.size() - output_offset)
+            return Result(Result::CorruptedTable);
+
+        std::memcpy(out.data() + output_offset, input + input_offset, literals_size);
+        input_offset += literals_size;
+        output_offset += literals_size;
+
+        // The last sequence of the block only contains literals.
+        if (input_offset == input_size)
+            break;
+
+        if (input_size - input_offset < 2)
+            return Result(Result::CorruptedTable);
+        const usize match_offset = input[input_offset] | (static_cast<usize>(input[input_offset + 1]) << 8);
+        input_offset += 2;
+        if (match_offset == 0 || match_offset > output_offset)
+            return Result(Result::CorruptedTable);
+
+        usize match_size = token & lz4_run_mask;
+        if (match_size == lz4_run_mask)
+            TRY(read_length(match_size));
+        match_size += lz4_min_match_size;
+        if (match_size > out.size() - output_offset)
+            return Result(Result::CorruptedTable);
+
+        // NOTE: The match can overlap the bytes it produces, which repeats the last bytes of the output, so it is
+        //       copied byte by byte unless it is far enough behind.
+        char* match_destination = out.data() + output_offset;
+        const char* match_source = match_destination - match_offset;
+        if (match_offset >= match_size)
+        {
+            std::memcpy(match_destination, match_source, match_size);
+        }
+        else
+        {
+            for (usize index = 0; index < match_size; ++index)
+                match_destination[index] = match_source[index];
+        }
+        output_offset += match_size;
+    }
+
+    if (output_offset != out.size())
+        return Result(Result::CorruptedTable);
+    return {};
+}
+
+void compress_block(BlockCompression compression, StringView block, String& out)
+{
+    switch (compression)
+    {
+        case BlockCompression::None: out.append(block); return;
+        case BlockCompression::LZ4: compress_lz4_block(block, out); return;
+    }
+}
+
+ResultOr<void> decompress_block(BlockCompression compression, StringView compressed_block, Span<char> out)
+{
+    switch (compression)
+    {
+        case BlockCompression::None:
+            if (compressed_block.size() != out.size())
+                return Result(Result::CorruptedTable);
+            std::memcpy(out.data(), compressed_block.data(), out.size());
+            return {};
+        case BlockCompression::LZ4: return decompress_lz4_block(compressed_block, out);
+    }
+    return Result(Result::CorruptedTable);
+}
+
+} // namespace Octopus
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+
+namespace Octopus
+{
+
+enum class BlockCompression : u8
+{
+    /// The block is stored as it is.
+    None = 0,
+    /// The block is compressed in the LZ4 block format, which is fast enough to be decompressed at the speed of
+    /// the storage.
+    LZ4 = 1,
+};
+
+/// Accepts 'none' and 'lz4'.
+ResultOr<BlockCompression> parse_block_compression(StringView compression_name);
+NODISCARD StringView get_block_compression_name(BlockCompression compression);
+
+/// Appends the compressed block to the output. A block that doesn't compress is stored with a small overhead.
+void compress_block(BlockCompression compression, StringView block, String& out);
+
+/// Decompresses the block into the given buffer, whose size must be exactly the size of the original block.
+/// A malformed block is rejected with Result::CorruptedTable, without reading or writing outside of the buffers.
+ResultOr<void> decompress_block(BlockCompression compression, StringView compressed_block, Span<char> out);
+
+} // namespace Octopus
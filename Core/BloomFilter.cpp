@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "BloomFilter.h"
+
+namespace Octopus
+{
+
+/// Odd constants that select the bit of every word of the block, from the low half of the hash.
+static constexpr u32 s_block_word_salts[] = {
+    0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du, 0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u,
+};
+
+/// NOTE: The shards of a table are chosen by a multiplicative hash of the ticket ID, so the keys of a single shard
+///       share some of its bits. The filter uses a full avalanche mix (the finalizer of MurmurHash3) instead.
+NODISCARD ALWAYS_INLINE static u64 hash_key(u64 key)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+NODISCARD ALWAYS_INLINE static u64 get_word_mask(u64 hash, usize word_index)
+{
+    const u32 bit_index = (static_cast<u32>(hash) * s_block_word_salts[word_index]) >> 26;
+    return static_cast<u64>(1) << bit_index;
+}
+
+void BlockedBloomFilter::reset(usize key_capacity)
+{
+    if (key_capacity == 0)
+        key_capacity = 1;
+
+    constexpr usize bits_per_block = sizeof(Block) * 8;
+    const usize block_count = (key_capacity * bits_per_key + bits_per_block - 1) / bits_per_block;
+
+    m_blocks.assign(block_count, Block {});
+    m_key_capacity = key_capacity;
+    m_key_count = 0;
+}
+
+void BlockedBloomFilter::insert(u64 key)
+{
+    const u64 hash = hash_key(key);
+    Block& block = m_blocks[get_block_index(hash)];
+    for (usize word_index = 0; word_index < words_per_block; ++word_index)
+        block.words[word_index] |= get_word_mask(hash, word_index);
+    ++m_key_count;
+}
+
+bool BlockedBloomFilter::might_contain(u64 key) const
+{
+    // An empty filter has no blocks, until it is reset for the first time.
+    if (m_blocks.empty())
+        return false;
+
+    const u64 hash = hash_key(key);
+    const Block& block = m_blocks[get_block_index(hash)];
+    for (usize word_index = 0; word_index < words_per_block; ++word_index)
+    {
+        const u64 mask = get_word_mask(hash, word_index);
+        if ((block.words[word_index] & mask) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace Octopus
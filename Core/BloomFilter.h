@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+
+namespace Octopus
+{
+
+///
+/// Compact set of keys that answers whether a key might be present, without ever missing a key that was inserted.
+/// It is used to reject the lookups of keys that don't exist before walking the real container.
+///
+/// The filter is split into blocks the size of a cache line, and all the bits of a key live in a single block (one
+/// bit in each of its words). A query therefore touches exactly one cache line, no matter how large the filter is.
+/// With 16 bits per key, fewer than 0.1% of the keys that were never inserted are reported as present, even once
+/// the filter holds as many keys as it was sized for.
+///
+/// Keys can't be removed. A removed key stays present in the filter until it is rebuilt, which only makes the filter
+/// slightly less selective. The filter isn't synchronized: it must be modified under the same exclusive lock as the
+/// container it describes.
+///
+class BlockedBloomFilter
+{
+public:
+    static constexpr usize bits_per_key = 16;
+
+public:
+    /// Clears the filter and makes room for the given number of keys. The filter can hold more keys than that, but
+    /// it becomes less selective as it fills up.
+    void reset(usize key_capacity);
+
+    void insert(u64 key);
+    NODISCARD bool might_contain(u64 key) const;
+
+    NODISCARD ALWAYS_INLINE usize key_capacity() const { return m_key_capacity; }
+    /// The number of keys inserted since the last reset, including the keys that were removed from the container.
+    NODISCARD ALWAYS_INLINE usize key_count() const { return m_key_count; }
+
+private:
+    static constexpr usize words_per_block = 8;
+
+    struct alignas(words_per_block * sizeof(u64)) Block
+    {
+        u64 words[words_per_block];
+    };
+
+private:
+    NODISCARD ALWAYS_INLINE usize get_block_index(u64 hash) const
+    {
+        // Maps the high half of the hash onto the blocks without a division.
+        return static_cast<usize>(((hash >> 32) * static_cast<u64>(m_blocks.size())) >> 32);
+    }
+
+private:
+    Vector<Block> m_blocks;
+    usize m_key_capacity = 0;
+    usize m_key_count = 0;
+};
+
+} // namespace Octopus
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Checksum.h"
+
+#include <cstring>
+
+// NOTE: The CRC-32C instructions were introduced with SSE4.2, so they are only used if the processor reports them at
+//       runtime. Defining OCTOPUS_NO_SIMD selects the lookup tables unconditionally.
+#if !defined(OCTOPUS_NO_SIMD) && (defined(_M_X64) || defined(__x86_64__))
+    #define OCTOPUS_CRC32C_SSE42 1
+    #include <nmmintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define OCTOPUS_TARGET_SSE42
+    #else
+        #include <cpuid.h>
+        #define OCTOPUS_TARGET_SSE42 __attribute__((target("sse4.2")))
+    #endif
+#else
+    #define OCTOPUS_CRC32C_SSE42 0
+#endif
+
+namespace Octopus
+{
+
+/// The CRC-32C polynomial, with its bits reversed.
+static constexpr u32 crc32c_polynomial = 0x82F63B78;
+
+struct CRC32CTables
+{
+    /// The first table is the classic byte-by-byte table. Every other table advances the CRC of the previous one by
+    /// one more zero byte, so that 8 bytes can be looked up independently of each other.
+    u32 tables[8][256];
+};
+
+static constexpr CRC32CTables generate_crc32c_tables()
+{
+    CRC32CTables result = {};
+    for (u32 byte = 0; byte < 256; ++byte)
+    {
+        u32 crc = byte;
+        for (u32 bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? ((crc >> 1) ^ crc32c_polynomial) : (crc >> 1);
+        result.tables[0][byte] = crc;
+    }
+
+    for (u32 byte = 0; byte < 256; ++byte)
+    {
+        for (usize table_index = 1; table_index < 8; ++table_index)
+        {
+            const u32 previous_crc = result.tables[table_index - 1][byte];
+            result.tables[table_index][byte] = (previous_crc >> 8) ^ result.tables[0][previous_crc & 0xFF];
+        }
+    }
+
+    return result;
+}
+
+static constexpr CRC32CTables s_crc32c_tables = generate_crc32c_tables();
+
+static u32 compute_crc32c_with_tables(const void* data, usize size, u32 previous_crc)
+{
+    const auto& tables = s_crc32c_tables.tables;
+    const u8* bytes = static_cast<const u8*>(data);
+    u32 crc = ~previous_crc;
+
+    // NOTE: The 8 bytes are combined with the CRC as a little-endian integer, which is what every supported
+    //       platform uses.
+    while (size >= 8)
+    {
+        u64 block;
+        std::memcpy(&block, bytes, sizeof(block));
+        block ^= crc;
+
+        crc = tables[7][block & 0xFF] ^ tables[6][(block >> 8) & 0xFF] ^ tables[5][(block >> 16) & 0xFF] ^
+              tables[4][(block >> 24) & 0xFF] ^ tables[3][(block >> 32) & 0xFF] ^ tables[2][(block >> 40) & 0xFF] ^
+              tables[1][(block >> 48) & 0xFF] ^ tables[0][block >> 56];
+
+        bytes += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *bytes) & 0xFF];
+        ++bytes;
+        --size;
+    }
+
+    return ~crc;
+}
+
+#if OCTOPUS_CRC32C_SSE42
+
+static bool is_sse42_supported()
+{
+    // The support for SSE4.2 is reported by bit 20 of ECX, in the first leaf of CPUID.
+    constexpr u32 sse42_bit = BIT(20);
+    #if defined(_MSC_VER)
+    int registers[4] = {};
+    __cpuid(registers, 1);
+    return (static_cast<u32>(registers[2]) & sse42_bit) != 0;
+    #else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (ecx & sse42_bit) != 0;
+    #endif
+}
+
+static const bool s_has_crc32c_instructions = is_sse42_supported();
+
+OCTOPUS_TARGET_SSE42 static u32 compute_crc32c_with_instructions(const void* data, usize size, u32 previous_crc)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    u64 crc = ~previous_crc;
+
+    while (size >= 8)
+    {
+        u64 block;
+        std::memcpy(&block, bytes, sizeof(block));
+        crc = _mm_crc32_u64(crc, block);
+
+        bytes += 8;
+        size -= 8;
+    }
+
+    u32 tail_crc = static_cast<u32>(crc);
+    while (size > 0)
+    {
+        tail_crc = _mm_crc32_u8(tail_crc, *bytes);
+        ++bytes;
+        --size;
+    }
+
+    return ~tail_crc;
+}
+
+#endif // OCTOPUS_CRC32C_SSE42
+
+u32 compute_crc32c(const void* data, usize size, u32 previous_crc)
+{
+#if OCTOPUS_CRC32C_SSE42
+    if (s_has_crc32c_instructions)
+        return compute_crc32c_with_instructions(data, size, previous_crc);
+#endif
+    return compute_crc32c_with_tables(data, size, previous_crc);
+}
+
+} // namespace Octopus
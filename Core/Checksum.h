@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+
+namespace Octopus
+{
+
+///
+/// Computes the CRC-32C (Castagnoli) checksum of the given bytes. A checksum can be computed incrementally, by
+/// passing the checksum of the previous bytes as the initial value.
+///
+/// The checksum is computed 8 bytes at a time, with the CRC32 instruction of SSE4.2 when the processor supports it, and
+/// with the slicing-by-8 lookup tables otherwise. Both produce the same checksum.
+///
+NODISCARD u32 compute_crc32c(const void* data, usize size, u32 previous_crc = 0);
+
+NODISCARD ALWAYS_INLINE u32 compute_crc32c(StringView data, u32 previous_crc = 0)
+{
+    return compute_crc32c(data.data(), data.size(), previous_crc);
+}
+
+} // namespace Octopus
@@ -6,16 +6,20 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <new>
 #include <optional>
 #include <set>
+#include <shared_mutex>
 #include <span>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
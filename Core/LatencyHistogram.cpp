@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <bit>
+
+namespace Octopus
+{
+
+void LatencyHistogram::record(u64 nanoseconds)
+{
+    m_buckets[get_bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+u64 LatencyHistogram::count_below(u64 nanoseconds) const
+{
+    u64 count = 0;
+    for (usize bucket_index = 0; bucket_index < bucket_count; ++bucket_index)
+    {
+        if (get_bucket_end(bucket_index) > nanoseconds)
+            break;
+        count += m_buckets[bucket_index].load(std::memory_order_relaxed);
+    }
+
+    return count;
+}
+
+usize LatencyHistogram::get_bucket_index(u64 value)
+{
+    // The smallest values are recorded exactly, one bucket for each value.
+    if (value < sub_bucket_count)
+        return static_cast<usize>(value);
+
+    const u32 value_bit_count = static_cast<u32>(std::bit_width(value));
+    if (value_bit_count > max_value_bit_count)
+        return bucket_count - 1;
+
+    // NOTE: The sub-bucket is given by the bits that follow the most significant one. Every power of two gets
+    //       sub_bucket_count buckets, which are twice as wide as the buckets of the previous power of two.
+    const u32 shift = value_bit_count - sub_bucket_bit_count - 1;
+    const u64 sub_bucket_index = (value >> shift) & (sub_bucket_count - 1);
+    return static_cast<usize>((shift + 1) * sub_bucket_count + sub_bucket_index);
+}
+
+u64 LatencyHistogram::get_bucket_end(usize bucket_index)
+{
+    if (bucket_index < sub_bucket_count)
+        return bucket_index + 1;
+    // The last bucket also holds all the durations that are too long for the histogram.
+    if (bucket_index == bucket_count - 1)
+        return UINT64_MAX;
+
+    const u32 shift = static_cast<u32>(bucket_index / sub_bucket_count) - 1;
+    const u64 sub_bucket_index = bucket_index % sub_bucket_count;
+    return (sub_bucket_count + sub_bucket_index + 1) << shift;
+}
+
+} // namespace Octopus
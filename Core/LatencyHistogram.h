@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+
+namespace Octopus
+{
+
+///
+/// Histogram of durations, measured in nanoseconds, with a bounded relative error instead of fixed bucket widths.
+/// Every power of two is split into a few linear sub-buckets, so the same memory covers both nanoseconds and
+/// hours while every recorded value lands in a bucket that is at most 1/8 wider than the value itself.
+///
+/// Recording is a single relaxed atomic increment of the bucket, plus the running count and sum, so it never
+/// blocks and can be done from any thread.
+///
+class LatencyHistogram
+{
+public:
+    static constexpr u32 sub_bucket_bit_count = 3;
+    static constexpr u64 sub_bucket_count = static_cast<u64>(1) << sub_bucket_bit_count;
+    /// Longer durations are recorded in the last bucket, which covers a bit more than 19 hours.
+    static constexpr u32 max_value_bit_count = 46;
+    static constexpr usize bucket_count = (max_value_bit_count - sub_bucket_bit_count + 1) * sub_bucket_count;
+
+public:
+    void record(u64 nanoseconds);
+
+    NODISCARD ALWAYS_INLINE u64 count() const { return m_count.load(std::memory_order_relaxed); }
+    NODISCARD ALWAYS_INLINE u64 sum_nanoseconds() const { return m_sum_nanoseconds.load(std::memory_order_relaxed); }
+
+    /// Returns the number of recorded durations that were shorter than the given bound. The count is exact when the
+    /// bound is a power of two, as the bucket boundaries always line up with the powers of two.
+    NODISCARD u64 count_below(u64 nanoseconds) const;
+
+private:
+    NODISCARD static usize get_bucket_index(u64 value);
+    /// The first value that no longer belongs to the bucket.
+    NODISCARD static u64 get_bucket_end(usize bucket_index);
+
+private:
+    std::atomic<u64> m_buckets[bucket_count] = {};
+    std::atomic<u64> m_count = 0;
+    std::atomic<u64> m_sum_nanoseconds = 0;
+};
+
+} // namespace Octopus
@@ -25,4 +25,28 @@ ResultOr<u64> generate_random_unsigned(u64 closed_min, u64 closed_max)
     return generated_in_range;
 }
 
+char compute_base_36_luhn_character(StringView digits)
+{
+    constexpr u32 base = 36;
+
+    // NOTE: The check character is appended after the digits, so the rightmost digit is the one that is doubled.
+    u32 sum = 0;
+    bool should_double = true;
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it)
+    {
+        u32 addend = get_base_36_digit_value(*it);
+        if (should_double)
+        {
+            addend *= 2;
+            addend = (addend / base) + (addend % base);
+        }
+
+        sum += addend;
+        should_double = !should_double;
+    }
+
+    const u32 check_value = (base - (sum % base)) % base;
+    return get_base_36_digit_character(static_cast<u8>(check_value));
+}
+
 } // namespace Octopus
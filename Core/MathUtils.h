@@ -58,50 +58,78 @@ ResultOr<T> safe_unsigned_multiplication(T a, T b)
     return a * b;
 }
 
+/// Character appended to a base 36 number, which lets most typing mistakes be detected without knowing which numbers
+/// are valid.
+enum class Base36CheckCharacter : u8
+{
+    None,
+    /// The Luhn mod N algorithm, for N = 36. It detects every mistyped character and every swap of two adjacent
+    /// characters, except for swapping '0' and 'Z'.
+    LuhnMod36,
+};
+
+NODISCARD ALWAYS_INLINE u8 get_base_36_digit_value(char character)
+{
+    return (character <= '9') ? static_cast<u8>(character - '0') : static_cast<u8>(character - 'A' + 10);
+}
+
+NODISCARD ALWAYS_INLINE char get_base_36_digit_character(u8 digit)
+{
+    return (digit <= 9) ? static_cast<char>('0' + digit) : static_cast<char>('A' + (digit - 10));
+}
+
+/// The digits must be valid, uppercase, base 36 characters.
+NODISCARD char compute_base_36_luhn_character(StringView digits);
+
 template<typename T>
 requires ((std::is_integral_v<T> && std::is_unsigned_v<T>))
-String transform_to_base_36(T value)
+String transform_to_base_36(T value, Base36CheckCharacter check_character = Base36CheckCharacter::None)
 {
-    if (value == 0)
-        return "0";
-
     String result;
-    while (value != 0)
+    do
     {
-        const u8 digit = value % 36;
-        if (digit <= 9)
-            result.push_back('0' + digit);
-        else
-            result.push_back('A' + (digit - 10));
-
+        result.push_back(get_base_36_digit_character(static_cast<u8>(value % 36)));
         value /= 36;
-    }
+    } while (value != 0);
 
     std::reverse(result.begin(), result.end());
+    if (check_character == Base36CheckCharacter::LuhnMod36)
+        result.push_back(compute_base_36_luhn_character(result));
     return result;
 }
 
+/// If a check character is expected and it doesn't match the digits, Result::IdInvalid is returned.
 template<typename T>
 requires ((std::is_integral_v<T> && std::is_unsigned_v<T>))
-ResultOr<T> transform_from_base_36(StringView value)
+ResultOr<T> transform_from_base_36(StringView value, Base36CheckCharacter check_character = Base36CheckCharacter::None)
 {
-    T result = 0;
-
+    // The uppercase digits are needed to compute the check character. Ticket codes are short enough to never
+    // allocate memory.
+    String digits;
+    digits.reserve(value.size());
     for (char character : value)
     {
         character = static_cast<char>(std::toupper(character));
         if ((character < '0' || character > '9') && (character < 'A' || character > 'Z'))
             return Result(Result::InvalidParameter);
+        digits.push_back(character);
+    }
 
+    if (check_character == Base36CheckCharacter::LuhnMod36)
+    {
+        if (digits.size() < 2)
+            return Result(Result::IdInvalid);
+        const char expected_check_character = digits.back();
+        digits.pop_back();
+        if (compute_base_36_luhn_character(digits) != expected_check_character)
+            return Result(Result::IdInvalid);
+    }
+
+    T result = 0;
+    for (const char character : digits)
+    {
         TRY_ASSIGN(result, safe_unsigned_multiplication<T>(result, 36));
-        if (character <= '9')
-        {
-            TRY_ASSIGN(result, safe_unsigned_addition<T>(result, character - '0'))
-        }
-        else
-        {
-            TRY_ASSIGN(result, safe_unsigned_addition<T>(result, character - 'A' + 10))
-        }
+        TRY_ASSIGN(result, safe_unsigned_addition<T>(result, get_base_36_digit_value(character)));
     }
 
     return result;
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "NameFormat.h"
+
+#include <cstring>
+
+// NOTE: Every x64 processor supports SSE2. Defining OCTOPUS_NO_SIMD selects the scalar code instead.
+#if !defined(OCTOPUS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define OCTOPUS_NAME_FORMAT_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define OCTOPUS_NAME_FORMAT_SSE2 0
+#endif
+
+namespace Octopus
+{
+
+NODISCARD ALWAYS_INLINE static bool is_name_separator(char character)
+{
+    return character == ' ' || character == '-';
+}
+
+#if OCTOPUS_NAME_FORMAT_SSE2
+
+/// Checks that all characters are letters or separators and maps their case, 16 characters at a time. A letter is
+/// uppercase if it follows a separator or begins the name, and lowercase otherwise.
+static bool map_name_characters_sse2(char* characters, usize character_count)
+{
+    const __m128i ascii_case_bit = _mm_set1_epi8(0x20);
+    // NOTE: The comparisons are signed, so the bytes outside of ASCII are negative and never classified as letters.
+    const __m128i before_uppercase_a = _mm_set1_epi8('A' - 1);
+    const __m128i after_uppercase_z = _mm_set1_epi8('Z' + 1);
+    const __m128i before_lowercase_a = _mm_set1_epi8('a' - 1);
+    const __m128i after_lowercase_z = _mm_set1_epi8('z' + 1);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i dash = _mm_set1_epi8('-');
+
+    // The character that precedes the block, in the first lane. The name behaves as if it follows a separator.
+    __m128i previous_character = _mm_cvtsi32_si128('-');
+
+    for (usize offset = 0; offset < character_count; offset += 16)
+    {
+        // The last block is padded with letters, which don't change the mapping of the characters before them.
+        const usize block_size = std::min<usize>(character_count - offset, 16);
+        alignas(16) char padded_block[16];
+        __m128i block;
+        if (block_size == 16)
+        {
+            block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(characters + offset));
+        }
+        else
+        {
+            std::memset(padded_block, 'a', sizeof(padded_block));
+            std::memcpy(padded_block, characters + offset, block_size);
+            block = _mm_load_si128(reinterpret_cast<const __m128i*>(padded_block));
+        }
+
+        const __m128i is_uppercase =
+            _mm_and_si128(_mm_cmpgt_epi8(block, before_uppercase_a), _mm_cmplt_epi8(block, after_uppercase_z));
+        const __m128i lowercase = _mm_or_si128(block, _mm_and_si128(is_uppercase, ascii_case_bit));
+        const __m128i is_letter =
+            _mm_and_si128(_mm_cmpgt_epi8(lowercase, before_lowercase_a), _mm_cmplt_epi8(lowercase, after_lowercase_z));
+        const __m128i is_separator = _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, dash));
+        if (_mm_movemask_epi8(_mm_or_si128(is_letter, is_separator)) != 0xFFFF)
+            return false;
+
+        const __m128i previous_block = _mm_or_si128(_mm_slli_si128(block, 1), previous_character);
+        const __m128i follows_separator =
+            _mm_or_si128(_mm_cmpeq_epi8(previous_block, space), _mm_cmpeq_epi8(previous_block, dash));
+        const __m128i begins_word = _mm_and_si128(is_letter, follows_separator);
+        const __m128i mapped_block = _mm_andnot_si128(_mm_and_si128(begins_word, ascii_case_bit), lowercase);
+
+        if (block_size == 16)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(characters + offset), mapped_block);
+        }
+        else
+        {
+            _mm_store_si128(reinterpret_cast<__m128i*>(padded_block), mapped_block);
+            std::memcpy(characters + offset, padded_block, block_size);
+        }
+
+        previous_character = _mm_srli_si128(block, 15);
+    }
+
+    return true;
+}
+
+#endif // OCTOPUS_NAME_FORMAT_SSE2
+
+/// Checks that all characters are letters or separators and maps their case. A letter is uppercase if it follows a
+/// separator or begins the name, and lowercase otherwise.
+static bool map_name_characters_scalar(char* characters, usize character_count)
+{
+    char previous_character = '-';
+    for (usize index = 0; index < character_count; ++index)
+    {
+        const char character = characters[index];
+        const char lowercase = (character >= 'A' && character <= 'Z') ? static_cast<char>(character | 0x20) : character;
+
+        if (lowercase >= 'a' && lowercase <= 'z')
+        {
+            const bool begins_word = is_name_separator(previous_character);
+            characters[index] = begins_word ? static_cast<char>(lowercase & ~0x20) : lowercase;
+        }
+        else if (!is_name_separator(character))
+            return false;
+
+        previous_character = character;
+    }
+
+    return true;
+}
+
+/// Removes the separators that must not be kept, once the characters were checked and mapped.
+static void remove_name_separators(String& name)
+{
+    // NOTE: Characters are only ever removed, so the formatted name is written over the one being read.
+    char last_character = '-';
+    usize formatted_size = 0;
+    for (usize index = 0; index < name.size(); ++index)
+    {
+        const char character = name[index];
+        if (is_name_separator(character) && last_character == '-')
+            continue;
+
+        last_character = character;
+        name[formatted_size++] = character;
+    }
+
+    if (is_name_separator(last_character) && formatted_size != 0)
+        --formatted_size;
+
+    name.resize(formatted_size);
+}
+
+bool are_name_characters_valid(StringView name)
+{
+    for (const char character : name)
+    {
+        const char lowercase = static_cast<char>(character | 0x20);
+        if ((lowercase < 'a' || lowercase > 'z') && !is_name_separator(character))
+            return false;
+    }
+
+    return true;
+}
+
+/// The implementation used by format_name_string(String&).
+static constexpr NameFormatPath fastest_name_format_path =
+    OCTOPUS_NAME_FORMAT_SSE2 ? NameFormatPath::SSE2 : NameFormatPath::Scalar;
+
+bool is_name_format_path_available(NameFormatPath path)
+{
+    switch (path)
+    {
+        case NameFormatPath::Scalar: return true;
+        case NameFormatPath::SSE2: return OCTOPUS_NAME_FORMAT_SSE2;
+    }
+
+    return false;
+}
+
+ResultOr<void> format_name_string(String& name)
+{
+    TRY(format_name_string(name, fastest_name_format_path));
+    return {};
+}
+
+ResultOr<void> format_name_string(String& name, NameFormatPath path)
+{
+    bool characters_are_valid = false;
+    switch (path)
+    {
+        case NameFormatPath::Scalar:
+        {
+            characters_are_valid = map_name_characters_scalar(name.data(), name.size());
+            break;
+        }
+
+        case NameFormatPath::SSE2:
+        {
+#if OCTOPUS_NAME_FORMAT_SSE2
+            characters_are_valid = map_name_characters_sse2(name.data(), name.size());
+            break;
+#else
+            return Result(Result::InvalidParameter);
+#endif // OCTOPUS_NAME_FORMAT_SSE2
+        }
+    }
+
+    if (!characters_are_valid)
+        return Result(Result::InvalidString);
+
+    remove_name_separators(name);
+    return {};
+}
+
+} // namespace Octopus
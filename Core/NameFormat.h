@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+
+namespace Octopus
+{
+
+/// The implementations of the pass that checks the characters of a name and maps their case. They produce the same
+/// result, but the vector one is only available if the target supports SSE2 and OCTOPUS_NO_SIMD isn't defined.
+enum class NameFormatPath : u8
+{
+    Scalar,
+    SSE2,
+};
+
+NODISCARD bool is_name_format_path_available(NameFormatPath path);
+
+///
+/// Formats the name in place, without allocating memory. Only ASCII letters, spaces and dashes are allowed. Every word
+/// is capitalized, the separators at the beginning of the name or after a dash are removed, and so is the last
+/// character of the name if it is a separator.
+///
+ResultOr<void> format_name_string(String& name);
+
+/// Returns whether the name only contains ASCII letters, spaces and dashes, which are the characters of a formatted
+/// name. Unlike formatting the name, this doesn't check the case of the letters or where the separators are.
+NODISCARD bool are_name_characters_valid(StringView name);
+
+/// Formats the name with the given implementation, which must be available. Only meant for checking the
+/// implementations against each other, as format_name_string(String&) always picks the fastest one.
+ResultOr<void> format_name_string(String& name, NameFormatPath path);
+
+} // namespace Octopus
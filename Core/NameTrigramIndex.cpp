@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "NameTrigramIndex.h"
+
+namespace Octopus
+{
+
+/// Only this many entries, the ones that share the most trigrams with the searched name, are compared to it.
+static constexpr usize min_name_search_candidate_count = 64;
+static constexpr usize name_search_candidates_per_match = 8;
+
+static constexpr char name_separator = ' ';
+
+/// Appends the name in lowercase, with every run of characters that aren't letters replaced by a single space.
+static void append_normalized_name(String& out, StringView name)
+{
+    for (const char character : name)
+    {
+        if (std::isalpha(static_cast<unsigned char>(character)))
+            out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(character))));
+        else if (!out.empty() && out.back() != name_separator)
+            out.push_back(name_separator);
+    }
+}
+
+/// Returns the names separated by a space, without leading or trailing spaces.
+static String normalize_full_name(StringView first_part, StringView second_part)
+{
+    String full_name;
+    full_name.reserve(first_part.size() + second_part.size() + 1);
+    append_normalized_name(full_name, first_part);
+    if (!full_name.empty() && full_name.back() != name_separator)
+        full_name.push_back(name_separator);
+    append_normalized_name(full_name, second_part);
+    if (!full_name.empty() && full_name.back() == name_separator)
+        full_name.pop_back();
+    return full_name;
+}
+
+NODISCARD ALWAYS_INLINE static u16 encode_name_character(char character)
+{
+    return (character == name_separator) ? 0 : static_cast<u16>(character - 'a' + 1);
+}
+
+/// Collects the distinct trigrams of the normalized name, sorted. The name is padded with a separator on both ends, so
+/// the first and last letters also begin and end trigrams.
+static void collect_trigrams(StringView normalized_name, Vector<u16>& out_trigrams)
+{
+    out_trigrams.clear();
+    if (normalized_name.empty())
+        return;
+
+    const usize padded_size = normalized_name.size() + 2;
+    const auto get_padded_character = [&](usize position) -> u16
+    {
+        if (position == 0 || position == padded_size - 1)
+            return encode_name_character(name_separator);
+        return encode_name_character(normalized_name[position - 1]);
+    };
+
+    for (usize position = 0; position + 3 <= padded_size; ++position)
+    {
+        const u16 trigram = static_cast<u16>(
+            (get_padded_character(position) << 10) | (get_padded_character(position + 1) << 5) |
+            get_padded_character(position + 2)
+        );
+        out_trigrams.push_back(trigram);
+    }
+
+    std::sort(out_trigrams.begin(), out_trigrams.end());
+    out_trigrams.erase(std::unique(out_trigrams.begin(), out_trigrams.end()), out_trigrams.end());
+}
+
+/// The Levenshtein distance between the strings, computed with two rows of the usual dynamic programming table.
+static u32 compute_edit_distance(StringView a, StringView b, Vector<u32>& row_buffer)
+{
+    row_buffer.resize(2 * (b.size() + 1));
+    u32* previous_row = row_buffer.data();
+    u32* current_row = row_buffer.data() + b.size() + 1;
+
+    for (usize column = 0; column <= b.size(); ++column)
+        previous_row[column] = static_cast<u32>(column);
+
+    for (usize row = 1; row <= a.size(); ++row)
+    {
+        current_row[0] = static_cast<u32>(row);
+        for (usize column = 1; column <= b.size(); ++column)
+        {
+            const u32 substitution_cost = (a[row - 1] == b[column - 1]) ? 0 : 1;
+            current_row[column] = std::min({
+                previous_row[column] + 1,
+                current_row[column - 1] + 1,
+                previous_row[column - 1] + substitution_cost,
+            });
+        }
+        std::swap(previous_row, current_row);
+    }
+
+    return previous_row[b.size()];
+}
+
+ResultOr<RefPtr<const NameTrigramIndex>> NameTrigramIndex::create(const TableEntryMap& entries)
+{
+    RefPtr<NameTrigramIndex> index = RefPtr<NameTrigramIndex>(new NameTrigramIndex());
+    if (!index)
+        return Result(Result::OutOfMemory);
+
+    if (entries.size() > static_cast<usize>(UINT32_MAX))
+        return Result(Result::IntegerOverflow);
+
+    index->m_entries.reserve(entries.size());
+    index->m_entry_trigram_counts.reserve(entries.size());
+    index->m_posting_offsets.assign(trigram_count + 1, 0);
+
+    // NOTE: The trigrams are collected twice: first to count the postings of every trigram, and then to fill them.
+    //       This way, all the postings live in a single array that is allocated only once.
+    Vector<u16> trigrams;
+    for (const auto& table_entry : entries)
+    {
+        const TableEntry& entry = table_entry.second;
+        collect_trigrams(normalize_full_name(entry.last_name, entry.first_name), trigrams);
+
+        index->m_entries.push_back(&table_entry);
+        index->m_entry_trigram_counts.push_back(static_cast<u8>(std::min<usize>(trigrams.size(), UINT8_MAX)));
+        for (const u16 trigram : trigrams)
+            ++index->m_posting_offsets[trigram + 1];
+    }
+
+    for (usize trigram = 0; trigram < trigram_count; ++trigram)
+        index->m_posting_offsets[trigram + 1] += index->m_posting_offsets[trigram];
+
+    index->m_postings.resize(index->m_posting_offsets[trigram_count]);
+    Vector<u32> posting_ends(index->m_posting_offsets.begin(), index->m_posting_offsets.end() - 1);
+    for (usize entry_index = 0; entry_index < index->m_entries.size(); ++entry_index)
+    {
+        const TableEntry& entry = index->m_entries[entry_index]->second;
+        collect_trigrams(normalize_full_name(entry.last_name, entry.first_name), trigrams);
+        for (const u16 trigram : trigrams)
+            index->m_postings[posting_ends[trigram]++] = static_cast<u32>(entry_index);
+    }
+
+    return RefPtr<const NameTrigramIndex>(std::move(index));
+}
+
+Vector<NameTrigramMatch>
+NameTrigramIndex::search(StringView last_name, StringView first_name, usize max_match_count) const
+{
+    Vector<NameTrigramMatch> matches;
+
+    // People often say their names in the other order, so both orders are compared.
+    const String searched_name = normalize_full_name(last_name, first_name);
+    const String swapped_searched_name = normalize_full_name(first_name, last_name);
+
+    Vector<u16> searched_trigrams;
+    collect_trigrams(searched_name, searched_trigrams);
+    if (searched_trigrams.empty() || max_match_count == 0)
+        return matches;
+
+    // Counts the trigrams that every entry shares with the searched name. Only the entries that share at least one
+    // of them are visited.
+    Vector<u16> shared_trigram_counts(m_entries.size(), 0);
+    Vector<u32> candidates;
+    for (const u16 trigram : searched_trigrams)
+    {
+        for (u32 offset = m_posting_offsets[trigram]; offset < m_posting_offsets[trigram + 1]; ++offset)
+        {
+            const u32 entry_index = m_postings[offset];
+            if (shared_trigram_counts[entry_index]++ == 0)
+                candidates.push_back(entry_index);
+        }
+    }
+
+    // The candidates are ranked by the Jaccard similarity of their trigrams, so that long names aren't favored just
+    // because they contain more trigrams.
+    const auto get_similarity = [&](u32 entry_index) -> float
+    {
+        const u32 shared_count = shared_trigram_counts[entry_index];
+        const u32 union_count =
+            static_cast<u32>(searched_trigrams.size()) + m_entry_trigram_counts[entry_index] - shared_count;
+        return static_cast<float>(shared_count) / static_cast<float>(std::max<u32>(union_count, 1));
+    };
+
+    const usize candidate_count = std::min(
+        candidates.size(),
+        std::max(min_name_search_candidate_count, max_match_count * name_search_candidates_per_match)
+    );
+    std::partial_sort(
+        candidates.begin(),
+        candidates.begin() + static_cast<i64>(candidate_count),
+        candidates.end(),
+        [&](u32 a, u32 b)
+        {
+            const float a_similarity = get_similarity(a);
+            const float b_similarity = get_similarity(b);
+            return (a_similarity != b_similarity) ? (a_similarity > b_similarity) : (a < b);
+        }
+    );
+    candidates.resize(candidate_count);
+
+    Vector<u32> row_buffer;
+    matches.reserve(candidate_count);
+    for (const u32 entry_index : candidates)
+    {
+        const TableEntry& entry = m_entries[entry_index]->second;
+        const String entry_name = normalize_full_name(entry.last_name, entry.first_name);
+
+        NameTrigramMatch& match = matches.emplace_back();
+        match.table_entry = m_entries[entry_index];
+        match.distance = std::min(
+            compute_edit_distance(searched_name, entry_name, row_buffer),
+            compute_edit_distance(swapped_searched_name, entry_name, row_buffer)
+        );
+    }
+
+    std::sort(
+        matches.begin(),
+        matches.end(),
+        [](const NameTrigramMatch& a, const NameTrigramMatch& b)
+        {
+            if (a.distance != b.distance)
+                return a.distance < b.distance;
+            return a.table_entry->first < b.table_entry->first;
+        }
+    );
+    if (matches.size() > max_match_count)
+        matches.resize(max_match_count);
+
+    return matches;
+}
+
+} // namespace Octopus
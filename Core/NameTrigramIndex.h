@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Table.h"
+
+namespace Octopus
+{
+
+struct NameTrigramMatch
+{
+    const TableEntryMap::value_type* table_entry;
+    /// The number of characters that must be inserted, removed or replaced to turn the searched name into the name
+    /// of the entry, in either order of the names.
+    u32 distance;
+};
+
+///
+/// Inverted index from the trigrams (sequences of three characters) of the names to the entries that contain them.
+/// It finds the entries whose names are similar to a misspelled name, without computing the edit distance to the name
+/// of every entry: only the entries that share the most trigrams with the searched name are compared to it.
+///
+/// Names are compared without case, and dashes are treated as spaces. The index refers to the entries of a table
+/// storage, so it is valid only as long as the storage isn't modified.
+///
+class NameTrigramIndex
+{
+public:
+    OCT_NONCOPYABLE(NameTrigramIndex)
+    OCT_NONMOVABLE(NameTrigramIndex)
+    ~NameTrigramIndex() = default;
+
+public:
+    static ResultOr<RefPtr<const NameTrigramIndex>> create(const TableEntryMap& entries);
+
+    /// Returns at most the given number of entries, sorted by their edit distance to the given name and then by their
+    /// ticket ID. Entries that don't share any trigram with the name are never returned.
+    NODISCARD Vector<NameTrigramMatch>
+    search(StringView last_name, StringView first_name, usize max_match_count) const;
+
+private:
+    /// Names only contain letters and separators, so a character fits in 5 bits.
+    static constexpr usize character_bit_count = 5;
+    static constexpr usize trigram_count = static_cast<usize>(1) << (3 * character_bit_count);
+
+private:
+    NameTrigramIndex() = default;
+
+private:
+    Vector<const TableEntryMap::value_type*> m_entries;
+    /// The number of distinct trigrams of every entry.
+    Vector<u8> m_entry_trigram_counts;
+
+    /// The postings of a trigram are the indices of the entries that contain it, stored between its offset and the
+    /// offset of the next trigram.
+    Vector<u32> m_posting_offsets;
+    Vector<u32> m_postings;
+};
+
+} // namespace Octopus
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "PoolAllocator.h"
+
+namespace Octopus
+{
+
+/// Every block is aligned to this value, which is the alignment guaranteed by the global operator new.
+static constexpr usize slab_block_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+SlabPool::~SlabPool()
+{
+    for (void* slab : m_slabs)
+        ::operator delete(slab);
+}
+
+void* SlabPool::allocate_block(usize block_size, usize block_alignment)
+{
+    SizeClass* size_class = find_size_class(block_size, block_alignment, true);
+    if (!size_class)
+        return nullptr;
+
+    if (size_class->free_list)
+    {
+        FreeBlock* block = size_class->free_list;
+        size_class->free_list = block->next;
+        return block;
+    }
+
+    if (size_class->slab_remaining_block_count == 0)
+    {
+        // NOTE: The slabs grow geometrically, so that small containers don't waste memory while
+        //       large ones still allocate very rarely.
+        const usize block_count = size_class->next_slab_block_count;
+        void* slab = ::operator new(block_count * size_class->block_size);
+        m_slabs.push_back(slab);
+
+        size_class->slab_cursor = static_cast<u8*>(slab);
+        size_class->slab_remaining_block_count = block_count;
+        size_class->next_slab_block_count = std::min(block_count * 2, max_slab_block_count);
+    }
+
+    void* block = size_class->slab_cursor;
+    size_class->slab_cursor += size_class->block_size;
+    --size_class->slab_remaining_block_count;
+    return block;
+}
+
+bool SlabPool::deallocate_block(void* block, usize block_size, usize block_alignment)
+{
+    SizeClass* size_class = find_size_class(block_size, block_alignment, false);
+    if (!size_class)
+        return false;
+
+    FreeBlock* free_block = static_cast<FreeBlock*>(block);
+    free_block->next = size_class->free_list;
+    size_class->free_list = free_block;
+    return true;
+}
+
+SlabPool::SizeClass* SlabPool::find_size_class(usize block_size, usize block_alignment, bool create_if_missing)
+{
+    if (block_alignment > slab_block_alignment)
+        return nullptr;
+
+    // Every block must be able to hold the free list link and must keep the next block aligned.
+    block_size = std::max(block_size, sizeof(FreeBlock));
+    block_size = (block_size + slab_block_alignment - 1) & ~(slab_block_alignment - 1);
+
+    for (usize index = 0; index < m_size_class_count; ++index)
+    {
+        if (m_size_classes[index].block_size == block_size)
+            return &m_size_classes[index];
+    }
+
+    if (!create_if_missing || m_size_class_count == max_size_class_count)
+        return nullptr;
+
+    SizeClass& size_class = m_size_classes[m_size_class_count++];
+    size_class.block_size = block_size;
+    size_class.next_slab_block_count = first_slab_block_count;
+    return &size_class;
+}
+
+} // namespace Octopus
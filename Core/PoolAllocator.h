@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+
+namespace Octopus
+{
+
+///
+/// Hands out fixed-size memory blocks that are carved from large slabs, instead of allocating each block separately.
+/// Freed blocks are kept in a free list and reused by the following allocations. The slabs are only released when
+/// the pool is destroyed.
+///
+/// A pool serves a few different block sizes, each from its own slabs. The pool isn't thread-safe: all allocations
+/// and deallocations must be synchronized by its owner.
+///
+class SlabPool
+{
+public:
+    OCT_NONCOPYABLE(SlabPool)
+    OCT_NONMOVABLE(SlabPool)
+
+    SlabPool() = default;
+    ~SlabPool();
+
+public:
+    /// Returns nullptr if the block can't be allocated from the pool, in which case the caller
+    /// should allocate it from the global heap instead.
+    NODISCARD void* allocate_block(usize block_size, usize block_alignment);
+
+    /// Returns false if the block wasn't allocated from the pool.
+    bool deallocate_block(void* block, usize block_size, usize block_alignment);
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct SizeClass
+    {
+        usize block_size = 0;
+        FreeBlock* free_list = nullptr;
+
+        /// The blocks of the most recent slab that were never handed out.
+        u8* slab_cursor = nullptr;
+        usize slab_remaining_block_count = 0;
+        usize next_slab_block_count = 0;
+    };
+
+    NODISCARD SizeClass* find_size_class(usize block_size, usize block_alignment, bool create_if_missing);
+
+private:
+    static constexpr usize max_size_class_count = 4;
+    static constexpr usize first_slab_block_count = 64;
+    static constexpr usize max_slab_block_count = 16 * 1024;
+
+    SizeClass m_size_classes[max_size_class_count];
+    usize m_size_class_count = 0;
+    Vector<void*> m_slabs;
+};
+
+///
+/// Standard allocator that allocates single objects from a slab pool. It is meant for node-based containers, whose
+/// elements are allocated one at a time. Copies of the allocator (including rebound ones) share the same pool,
+/// while copying a container gives the copy its own pool.
+///
+template<typename T>
+class PoolAllocator
+{
+    template<typename U>
+    friend class PoolAllocator;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+public:
+    PoolAllocator()
+        : m_pool(std::make_shared<SlabPool>())
+    {
+    }
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+        : m_pool(other.m_pool)
+    {
+    }
+
+    NODISCARD T* allocate(usize count)
+    {
+        if (count == 1)
+        {
+            void* block = m_pool->allocate_block(sizeof(T), alignof(T));
+            if (block)
+                return static_cast<T*>(block);
+        }
+
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* pointer, usize count)
+    {
+        if (count == 1 && m_pool->deallocate_block(pointer, sizeof(T), alignof(T)))
+            return;
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    NODISCARD PoolAllocator select_on_container_copy_construction() const { return PoolAllocator(); }
+
+    template<typename U>
+    NODISCARD bool operator==(const PoolAllocator<U>& other) const
+    {
+        return m_pool == other.m_pool;
+    }
+
+private:
+    RefPtr<SlabPool> m_pool;
+};
+
+} // namespace Octopus
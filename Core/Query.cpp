@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Query.h"
+#include "MathUtils.h"
+
+#include <format>
+
+namespace Octopus
+{
+
+struct QueryFieldDescription
+{
+    StringView name;
+    QueryField field;
+};
+
+static constexpr QueryFieldDescription s_query_fields[] = {
+    { "id", QueryField::TicketID },     { "first_name", QueryField::FirstName }, { "last_name", QueryField::LastName },
+    { "grade", QueryField::Grade },     { "grade_id", QueryField::GradeID },     { "class", QueryField::Class },
+    { "scans", QueryField::ScanCount }, { "last_scan", QueryField::LastScan },   { "flags", QueryField::Flags },
+};
+
+static constexpr QueryField s_default_query_columns[] = {
+    QueryField::TicketID, QueryField::LastName,  QueryField::FirstName,
+    QueryField::Class,    QueryField::ScanCount, QueryField::LastScan,
+};
+
+static ResultOr<QueryField> parse_query_field(StringView name)
+{
+    for (const QueryFieldDescription& description : s_query_fields)
+    {
+        if (description.name == name)
+            return description.field;
+    }
+
+    return Result(Result::InvalidQuery);
+}
+
+/// Splits the string at the given separator. Empty parts are not allowed.
+static ResultOr<Vector<StringView>> split_query_list(StringView list, char separator)
+{
+    Vector<StringView> parts;
+    usize offset = 0;
+    while (true)
+    {
+        usize separator_offset = list.find(separator, offset);
+        if (separator_offset == StringView::npos)
+            separator_offset = list.size();
+
+        if (separator_offset == offset)
+            return Result(Result::InvalidQuery);
+        parts.push_back(list.substr(offset, separator_offset - offset));
+
+        if (separator_offset == list.size())
+            break;
+        offset = separator_offset + 1;
+    }
+
+    return parts;
+}
+
+NODISCARD ALWAYS_INLINE static bool is_string_field(QueryField field)
+{
+    return field == QueryField::FirstName || field == QueryField::LastName;
+}
+
+NODISCARD ALWAYS_INLINE static i64 encode_class(u8 grade, char grade_id)
+{
+    return static_cast<i64>(grade) * 256 + static_cast<u8>(grade_id);
+}
+
+/// Every field, except the names, is compared as an integer.
+NODISCARD static i64 get_integer_field_value(QueryField field, TicketID ticket_id, const TableEntry& entry)
+{
+    switch (field)
+    {
+        case QueryField::TicketID: return static_cast<i64>(ticket_id);
+        case QueryField::Grade: return entry.grade;
+        case QueryField::GradeID: return static_cast<u8>(entry.grade_id);
+        case QueryField::Class: return encode_class(entry.grade, entry.grade_id);
+        case QueryField::ScanCount: return entry.metadata.scan_count.load(std::memory_order_relaxed);
+        case QueryField::LastScan: return entry.metadata.last_scan_timestamp.load(std::memory_order_relaxed);
+        case QueryField::Flags: return entry.metadata.flags;
+        case QueryField::FirstName:
+        case QueryField::LastName: break;
+    }
+
+    return 0;
+}
+
+NODISCARD ALWAYS_INLINE static const String& get_string_field_value(QueryField field, const TableEntry& entry)
+{
+    return (field == QueryField::FirstName) ? entry.first_name : entry.last_name;
+}
+
+static ResultOr<i64>
+parse_integer_field_value(const TableSnapshot& table_snapshot, QueryField field, StringView value)
+{
+    switch (field)
+    {
+        case QueryField::TicketID:
+        {
+            TRY_ASSIGN(const TicketID ticket_id, table_snapshot.parse_ticket_code(value));
+            return static_cast<i64>(ticket_id);
+        }
+
+        case QueryField::GradeID:
+        {
+            if (value.size() != 1)
+                return Result(Result::InvalidQuery);
+            return static_cast<i64>(std::toupper(value[0]));
+        }
+
+        case QueryField::Class:
+        {
+            if (value.size() < 2)
+                return Result(Result::InvalidQuery);
+            const StringView grade_string = value.substr(0, value.size() - 1);
+            TRY_ASSIGN(const i64 grade, parse_integer_field_value(table_snapshot, QueryField::Grade, grade_string));
+            if (grade > UINT8_MAX)
+                return Result(Result::InvalidQuery);
+            const char grade_id = static_cast<char>(std::toupper(value.back()));
+            return encode_class(static_cast<u8>(grade), grade_id);
+        }
+
+        case QueryField::LastScan:
+        {
+            auto result_or_timestamp = parse_scan_timestamp(value);
+            if (result_or_timestamp.is_result())
+                return Result(Result::InvalidQuery);
+            return result_or_timestamp.release_value();
+        }
+
+        case QueryField::Grade:
+        case QueryField::ScanCount:
+        case QueryField::Flags:
+        {
+            // NOTE: The values of these fields are small, so 9 digits can never overflow and are always enough.
+            if (value.empty() || value.size() > 9)
+                return Result(Result::InvalidQuery);
+
+            i64 integer_value = 0;
+            for (const char digit : value)
+            {
+                if (digit < '0' || digit > '9')
+                    return Result(Result::InvalidQuery);
+                integer_value = integer_value * 10 + (digit - '0');
+            }
+            return integer_value;
+        }
+
+        case QueryField::FirstName:
+        case QueryField::LastName: break;
+    }
+
+    return Result(Result::InvalidQuery);
+}
+
+template<typename T>
+NODISCARD ALWAYS_INLINE static bool compare_query_values(const T& lhs, QueryOperator op, const T& rhs)
+{
+    switch (op)
+    {
+        case QueryOperator::Equal: return lhs == rhs;
+        case QueryOperator::NotEqual: return lhs != rhs;
+        case QueryOperator::Less: return lhs < rhs;
+        case QueryOperator::LessOrEqual: return lhs <= rhs;
+        case QueryOperator::Greater: return lhs > rhs;
+        case QueryOperator::GreaterOrEqual: return lhs >= rhs;
+    }
+
+    return false;
+}
+
+ResultOr<OwnPtr<Query>>
+Query::create(const TableSnapshot& table_snapshot, StringView filter, StringView order, StringView columns)
+{
+    OwnPtr<Query> query = OwnPtr<Query>(new Query());
+    if (!query)
+        return Result(Result::OutOfMemory);
+
+    TRY(query->parse_filter(table_snapshot, filter));
+    TRY(query->parse_order(order));
+    TRY(query->parse_columns(columns));
+    return query;
+}
+
+StringView Query::get_field_name(QueryField field)
+{
+    for (const QueryFieldDescription& description : s_query_fields)
+    {
+        if (description.field == field)
+            return description.name;
+    }
+
+    return {};
+}
+
+ResultOr<String> Query::format_field(
+    const TableSnapshot& table_snapshot,
+    QueryField field,
+    TicketID ticket_id,
+    const TableEntry& entry
+)
+{
+    switch (field)
+    {
+        case QueryField::TicketID: return table_snapshot.format_ticket_code(ticket_id);
+        case QueryField::FirstName: return entry.first_name;
+        case QueryField::LastName: return entry.last_name;
+        case QueryField::Grade: return std::format("{}", static_cast<u32>(entry.grade));
+        case QueryField::GradeID: return String(1, entry.grade_id);
+        case QueryField::Class: return std::format("{}{}", static_cast<u32>(entry.grade), entry.grade_id);
+        case QueryField::ScanCount: return std::format("{}", entry.metadata.scan_count.load());
+        case QueryField::LastScan: return format_scan_timestamp(entry.metadata.last_scan_timestamp);
+        case QueryField::Flags: return std::format("{}", entry.metadata.flags);
+    }
+
+    return Result(Result::InvalidQuery);
+}
+
+ResultOr<void> Query::parse_filter(const TableSnapshot& table_snapshot, StringView filter)
+{
+    if (filter == "all")
+        return {};
+
+    TRY_ASSIGN(const Vector<StringView> conditions, split_query_list(filter, '&'));
+    for (const StringView condition_string : conditions)
+    {
+        const usize operator_offset = condition_string.find_first_of("!<>=");
+        if (operator_offset == StringView::npos || operator_offset == 0)
+            return Result(Result::InvalidQuery);
+
+        Condition condition;
+        TRY_ASSIGN(condition.field, parse_query_field(condition_string.substr(0, operator_offset)));
+
+        StringView value = condition_string.substr(operator_offset);
+        if (value.starts_with("!="))
+            condition.op = QueryOperator::NotEqual;
+        else if (value.starts_with("<="))
+            condition.op = QueryOperator::LessOrEqual;
+        else if (value.starts_with(">="))
+            condition.op = QueryOperator::GreaterOrEqual;
+        else if (value.starts_with('='))
+            condition.op = QueryOperator::Equal;
+        else if (value.starts_with('<'))
+            condition.op = QueryOperator::Less;
+        else if (value.starts_with('>'))
+            condition.op = QueryOperator::Greater;
+        else
+            return Result(Result::InvalidQuery);
+
+        const bool is_two_characters_operator = (condition.op == QueryOperator::NotEqual) ||
+                                                (condition.op == QueryOperator::LessOrEqual) ||
+                                                (condition.op == QueryOperator::GreaterOrEqual);
+        value.remove_prefix(is_two_characters_operator ? 2 : 1);
+        if (value.empty())
+            return Result(Result::InvalidQuery);
+
+        if (is_string_field(condition.field))
+        {
+            // The names in the table are always formatted, so the value must be formatted the same way.
+            condition.string_value = value;
+            auto result_or_void = Table::format_name(condition.string_value);
+            if (result_or_void.is_result())
+                return Result(Result::InvalidQuery);
+        }
+        else
+        {
+            TRY_ASSIGN(condition.integer_value, parse_integer_field_value(table_snapshot, condition.field, value));
+        }
+
+        if (condition.field == QueryField::TicketID && condition.op == QueryOperator::Equal)
+            m_ticket_id = static_cast<TicketID>(condition.integer_value);
+
+        m_conditions.push_back(std::move(condition));
+    }
+
+    // Comparing integers is cheaper than comparing strings, so they are evaluated first.
+    std::stable_sort(
+        m_conditions.begin(),
+        m_conditions.end(),
+        [](const Condition& a, const Condition& b) { return !is_string_field(a.field) && is_string_field(b.field); }
+    );
+
+    return {};
+}
+
+ResultOr<void> Query::parse_order(StringView order)
+{
+    if (order.empty() || order == "none")
+        return {};
+
+    TRY_ASSIGN(const Vector<StringView> keys, split_query_list(order, ','));
+    for (StringView key : keys)
+    {
+        OrderKey order_key;
+        order_key.is_descending = key.starts_with('-');
+        if (order_key.is_descending)
+            key.remove_prefix(1);
+
+        TRY_ASSIGN(order_key.field, parse_query_field(key));
+        m_order.push_back(order_key);
+    }
+
+    return {};
+}
+
+ResultOr<void> Query::parse_columns(StringView columns)
+{
+    if (columns.empty())
+    {
+        m_columns.assign(std::begin(s_default_query_columns), std::end(s_default_query_columns));
+        return {};
+    }
+
+    TRY_ASSIGN(const Vector<StringView> fields, split_query_list(columns, ','));
+    for (const StringView field_name : fields)
+    {
+        TRY_ASSIGN(const QueryField field, parse_query_field(field_name));
+        m_columns.push_back(field);
+    }
+
+    return {};
+}
+
+bool Query::matches(TicketID ticket_id, const TableEntry& entry) const
+{
+    for (const Condition& condition : m_conditions)
+    {
+        if (is_string_field(condition.field))
+        {
+            const String& value = get_string_field_value(condition.field, entry);
+            if (!compare_query_values<StringView>(value, condition.op, condition.string_value))
+                return false;
+        }
+        else
+        {
+            const i64 value = get_integer_field_value(condition.field, ticket_id, entry);
+            if (!compare_query_values(value, condition.op, condition.integer_value))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+i64 Query::get_match_integer_value(QueryField field, const Match& match)
+{
+    if (field == QueryField::ScanCount)
+        return match.scan_count;
+    if (field == QueryField::LastScan)
+        return match.last_scan_timestamp;
+    return get_integer_field_value(field, match.ticket_id, *match.entry);
+}
+
+void Query::sort_matches(Vector<Match>& matches) const
+{
+    const auto compare_matches = [this](const Match& a, const Match& b) -> bool
+    {
+        for (const OrderKey& order_key : m_order)
+        {
+            i32 comparison;
+            if (is_string_field(order_key.field))
+            {
+                const String& a_value = get_string_field_value(order_key.field, *a.entry);
+                const String& b_value = get_string_field_value(order_key.field, *b.entry);
+                comparison = a_value.compare(b_value);
+            }
+            else
+            {
+                const i64 a_value = get_match_integer_value(order_key.field, a);
+                const i64 b_value = get_match_integer_value(order_key.field, b);
+                comparison = (a_value < b_value) ? -1 : ((a_value > b_value) ? 1 : 0);
+            }
+
+            if (comparison != 0)
+                return order_key.is_descending ? (comparison > 0) : (comparison < 0);
+        }
+
+        // The entries that are equal by all keys are kept in the order of their ticket IDs.
+        return a.ticket_id < b.ticket_id;
+    };
+
+    std::sort(matches.begin(), matches.end(), compare_matches);
+}
+
+} // namespace Octopus
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Table.h"
+
+namespace Octopus
+{
+
+enum class QueryField : u8
+{
+    TicketID,
+    FirstName,
+    LastName,
+    Grade,
+    GradeID,
+    Class,
+    ScanCount,
+    LastScan,
+    Flags,
+};
+
+enum class QueryOperator : u8
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessOrEqual,
+    Greater,
+    GreaterOrEqual,
+};
+
+///
+/// A query selects the table entries that satisfy a filter, optionally sorted by some of their fields.
+///
+/// The filter is either 'all' or a list of conditions separated by '&', all of which must be satisfied. A condition
+/// is written as '<field><operator><value>', without spaces, where the operator is one of '=', '!=', '<', '<=', '>'
+/// and '>='. The available fields are:
+///     id          The ticket ID, such as 'F1BUC', written with the check character if the table uses one.
+///     first_name  The first name. The value is formatted the same way the names in the table are.
+///     last_name   The last name. The value is formatted the same way the names in the table are.
+///     grade       The grade, as a number between 9 and 12.
+///     grade_id    The letter of the class, such as 'C'.
+///     class       The grade and the letter of the class, such as '11C'.
+///     scans       The number of times the ticket was scanned.
+///     last_scan   The last scan date, written as 'day/month/year-hour:minute:second' or 'N/A'.
+///     flags       The flags of the entry, as a number.
+///
+/// For example, 'class=11C&scans=0' selects the unscanned tickets of the 11C class.
+///
+/// The order is either 'none' or a list of fields separated by ',', each prefixed by '-' for descending order. The
+/// columns are a list of fields separated by ',', which describes how the selected entries are presented.
+///
+class Query
+{
+public:
+    OCT_NONCOPYABLE(Query)
+    OCT_NONMOVABLE(Query)
+    ~Query() = default;
+
+public:
+    /// Parses the query and prepares its execution plan. The order and the columns can be empty. The ticket codes of
+    /// the filter are parsed in the format of the given snapshot, which is the one the query is executed on.
+    static ResultOr<OwnPtr<Query>> create(
+        const TableSnapshot& table_snapshot,
+        StringView filter,
+        StringView order = {},
+        StringView columns = {}
+    );
+
+    /// Invokes the callback for every entry of the snapshot that satisfies the filter, in the order of the query.
+    /// If the query isn't ordered, the entries are passed to the callback as soon as they are found.
+    template<typename Func>
+    ResultOr<void> execute(const TableSnapshot& table_snapshot, Func callback) const
+    {
+        if (m_order.empty())
+        {
+            TRY(for_each_match(table_snapshot, callback));
+            return {};
+        }
+
+        // NOTE: Only references to the entries are collected, which the snapshot keeps alive.
+        Vector<Match> matches;
+        TRY(for_each_match(
+            table_snapshot,
+            [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+            {
+                Match& match = matches.emplace_back();
+                match.ticket_id = ticket_id;
+                match.entry = &entry;
+                match.scan_count = entry.metadata.scan_count.load(std::memory_order_relaxed);
+                match.last_scan_timestamp = entry.metadata.last_scan_timestamp.load(std::memory_order_relaxed);
+                return IterationDecision::Continue;
+            }
+        ));
+
+        sort_matches(matches);
+        for (const Match& match : matches)
+        {
+            TRY_ASSIGN(const IterationDecision decision, callback(match.ticket_id, *match.entry));
+            if (decision == IterationDecision::Break)
+                break;
+        }
+
+        return {};
+    }
+
+    NODISCARD ALWAYS_INLINE Span<const QueryField> columns() const { return m_columns; }
+
+    NODISCARD static StringView get_field_name(QueryField field);
+    static ResultOr<String>
+    format_field(const TableSnapshot& table_snapshot, QueryField field, TicketID ticket_id, const TableEntry& entry);
+
+private:
+    struct Condition
+    {
+        QueryField field;
+        QueryOperator op;
+        i64 integer_value = 0;
+        String string_value;
+    };
+
+    struct OrderKey
+    {
+        QueryField field;
+        bool is_descending;
+    };
+
+    struct Match
+    {
+        TicketID ticket_id;
+        const TableEntry* entry;
+
+        /// The scan counters can be changed by other threads, so they are read only once, to keep the order
+        /// consistent while the matches are sorted.
+        u32 scan_count;
+        i64 last_scan_timestamp;
+    };
+
+private:
+    Query() = default;
+
+    ResultOr<void> parse_filter(const TableSnapshot& table_snapshot, StringView filter);
+    ResultOr<void> parse_order(StringView order);
+    ResultOr<void> parse_columns(StringView columns);
+
+    NODISCARD bool matches(TicketID ticket_id, const TableEntry& entry) const;
+    NODISCARD static i64 get_match_integer_value(QueryField field, const Match& match);
+    void sort_matches(Vector<Match>& matches) const;
+
+    template<typename Func>
+    ResultOr<void> for_each_match(const TableSnapshot& table_snapshot, Func callback) const
+    {
+        // When the ticket ID is known, the entry is looked up directly instead of walking the whole table.
+        if (m_ticket_id.has_value())
+        {
+            auto result_or_entry = table_snapshot.get_entry(m_ticket_id.value());
+            if (result_or_entry.is_result())
+            {
+                const Result result = result_or_entry.release_result();
+                if (result.get_code() == Result::IdNotFound)
+                    return {};
+                return result;
+            }
+
+            const TableEntry& entry = result_or_entry.release_value();
+            if (matches(m_ticket_id.value(), entry))
+                TRY(callback(m_ticket_id.value(), entry));
+            return {};
+        }
+
+        TRY(table_snapshot.iterate_over_entries(
+            [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+            {
+                if (!matches(ticket_id, entry))
+                    return IterationDecision::Continue;
+                return callback(ticket_id, entry);
+            }
+        ));
+
+        return {};
+    }
+
+private:
+    /// The conditions are sorted so that the cheap ones are evaluated first.
+    Vector<Condition> m_conditions;
+    Vector<OrderKey> m_order;
+    Vector<QueryField> m_columns;
+
+    /// Set if one of the conditions requires a specific ticket ID.
+    Optional<TicketID> m_ticket_id;
+};
+
+} // namespace Octopus
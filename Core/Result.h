@@ -41,6 +41,13 @@ public:
         CorruptedTableEntry,
         InvalidYAML,
         BufferOverflow,
+        NetworkError,
+        ConnectionClosed,
+
+        // NOTE: New codes are only appended, as the values are printed and returned as the exit code of the program.
+        InvalidMessage,
+        InvalidQuery,
+        ScriptFailed,
     };
 
 public:
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "ScanRate.h"
+
+namespace Octopus
+{
+
+void ScanRateRecorder::record(i64 timestamp)
+{
+    if (timestamp < 0)
+        return;
+
+    const u64 second = static_cast<u64>(timestamp);
+    std::atomic<u64>& slot = m_slots[second % history_second_count];
+
+    u64 slot_value = slot.load(std::memory_order_relaxed);
+    while (true)
+    {
+        const u64 slot_second = slot_value >> count_bit_count;
+        u64 new_slot_value;
+
+        if (slot_second == second)
+        {
+            // NOTE: The count saturates instead of overflowing into the bits of the second. No gate comes anywhere
+            //       near this many scans per second.
+            if ((slot_value & count_mask) == count_mask)
+                return;
+            new_slot_value = slot_value + 1;
+        }
+        else if (slot_second < second)
+        {
+            new_slot_value = (second << count_bit_count) | 1;
+        }
+        else
+        {
+            // The slot already belongs to a more recent second, so this scan is older than the whole history.
+            return;
+        }
+
+        if (slot.compare_exchange_weak(slot_value, new_slot_value, std::memory_order_relaxed))
+            return;
+    }
+}
+
+u64 ScanRateRecorder::count_recent(i64 now, usize second_count) const
+{
+    return count_range(now + 1 - static_cast<i64>(second_count), now + 1);
+}
+
+u64 ScanRateRecorder::count_range(i64 begin_timestamp, i64 end_timestamp) const
+{
+    begin_timestamp = std::max(begin_timestamp, end_timestamp - static_cast<i64>(history_second_count));
+    begin_timestamp = std::max<i64>(begin_timestamp, 0);
+
+    u64 scan_count = 0;
+    for (i64 timestamp = begin_timestamp; timestamp < end_timestamp; ++timestamp)
+    {
+        const u64 second = static_cast<u64>(timestamp);
+        const u64 slot_value = m_slots[second % history_second_count].load(std::memory_order_relaxed);
+        if ((slot_value >> count_bit_count) == second)
+            scan_count += slot_value & count_mask;
+    }
+
+    return scan_count;
+}
+
+} // namespace Octopus
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+
+namespace Octopus
+{
+
+///
+/// Counts the scans of every second, over a fixed window of recent history. The counters live in a ring that is
+/// allocated once, so the memory doesn't depend on how long the event lasts, and recording a scan is a single
+/// lock-free update of one counter.
+///
+/// Every slot of the ring packs the second it belongs to together with its count, which means that a slot left
+/// over from a previous lap of the ring is recognized and restarted by the first scan that reaches it again.
+///
+class ScanRateRecorder
+{
+public:
+    /// The number of seconds for which the counts are kept.
+    static constexpr usize history_second_count = 60 * 60;
+
+public:
+    /// The timestamp is in seconds since the UNIX epoch. Scans older than the history are ignored.
+    void record(i64 timestamp);
+
+    /// Returns the number of scans recorded in the last given number of seconds, including the current one.
+    NODISCARD u64 count_recent(i64 now, usize second_count) const;
+    /// Returns the number of scans recorded between the given timestamps, excluding the end.
+    NODISCARD u64 count_range(i64 begin_timestamp, i64 end_timestamp) const;
+
+private:
+    static constexpr u32 count_bit_count = 24;
+    static constexpr u64 count_mask = (static_cast<u64>(1) << count_bit_count) - 1;
+
+private:
+    std::atomic<u64> m_slots[history_second_count] = {};
+};
+
+} // namespace Octopus
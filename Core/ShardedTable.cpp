@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "ShardedTable.h"
+#include "MathUtils.h"
+
+namespace Octopus
+{
+
+ResultOr<OwnPtr<ShardedTable>> ShardedTable::create_new(usize shard_count)
+{
+    if (shard_count == 0)
+        return Result(Result::InvalidParameter);
+
+    OwnPtr<ShardedTable> table = OwnPtr<ShardedTable>(new ShardedTable());
+    if (!table)
+        return Result(Result::OutOfMemory);
+
+    table->m_shards.reserve(shard_count);
+    for (usize shard_index = 0; shard_index < shard_count; ++shard_index)
+    {
+        TRY_ASSIGN(OwnPtr<Table> shard, Table::create_new());
+        table->m_shards.push_back(std::move(shard));
+    }
+
+    table->m_ticket_id_generation = 1;
+    return table;
+}
+
+ResultOr<OwnPtr<ShardedTable>> ShardedTable::create_from_file(const String& filepath, usize shard_count)
+{
+    // NOTE: The database file is loaded and validated by a regular table. Its entries are then moved to the
+    //       shards, without being checked again. The map nodes can't be moved between tables, as every map
+    //       allocates its nodes from its own pool.
+    TRY_ASSIGN(OwnPtr<Table> loaded_table, Table::create_from_file(filepath));
+    TRY_ASSIGN(OwnPtr<ShardedTable> table, ShardedTable::create_new(shard_count));
+
+    for (auto& [ticket_id, entry] : loaded_table->m_storage->entries)
+    {
+        Table& shard = table->get_shard(ticket_id);
+        shard.m_statistics.add_entry(entry);
+        shard.m_storage->entries.emplace_hint(shard.m_storage->entries.end(), ticket_id, std::move(entry));
+    }
+
+    for (const OwnPtr<Table>& shard : table->m_shards)
+        shard->rebuild_ticket_id_filter();
+
+    table->set_ticket_code_check_character(loaded_table->ticket_code_check_character());
+
+    return table;
+}
+
+ResultOr<void> ShardedTable::save_to_file(const String& filepath) const
+{
+    // NOTE: All shards are locked while their snapshots are taken, so that the file describes the table at a
+    //       single moment in time. Shards are always locked in the same order, so this can't deadlock. The file
+    //       itself is written without holding any lock.
+    Vector<TableSnapshot> shard_snapshots;
+    shard_snapshots.reserve(m_shards.size());
+    {
+        Vector<std::shared_lock<std::shared_mutex>> shard_locks;
+        shard_locks.reserve(m_shards.size());
+        for (const OwnPtr<Table>& shard : m_shards)
+            shard_locks.emplace_back(shard->m_mutex);
+
+        for (const OwnPtr<Table>& shard : m_shards)
+            shard_snapshots.push_back(TableSnapshot(shard->m_storage));
+    }
+
+    usize entry_count = 0;
+    for (const TableSnapshot& shard_snapshot : shard_snapshots)
+        entry_count += shard_snapshot.entry_count();
+
+    Vector<Table::EntryReference> entries;
+    entries.reserve(entry_count);
+    for (const TableSnapshot& shard_snapshot : shard_snapshots)
+    {
+        for (const auto& [ticket_id, entry] : shard_snapshot.m_storage->entries)
+            entries.push_back({ ticket_id, &entry });
+    }
+
+    std::sort(
+        entries.begin(),
+        entries.end(),
+        [](const Table::EntryReference& a, const Table::EntryReference& b) { return a.ticket_id < b.ticket_id; }
+    );
+
+    TRY(Table::save_entries_to_file(filepath, entries, ticket_code_check_character()));
+    return {};
+}
+
+void ShardedTable::set_ticket_code_check_character(Base36CheckCharacter check_character)
+{
+    m_ticket_code_check_character.store(check_character, std::memory_order_relaxed);
+}
+
+String ShardedTable::format_ticket_code(TicketID ticket_id) const
+{
+    return transform_to_base_36(ticket_id, ticket_code_check_character());
+}
+
+ResultOr<TicketID> ShardedTable::parse_ticket_code(StringView ticket_code) const
+{
+    TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_code, ticket_code_check_character()));
+    return ticket_id;
+}
+
+ResultOr<bool> ShardedTable::is_ticket_id_valid(TicketID ticket_id) const
+{
+    return get_shard(ticket_id).is_ticket_id_valid(ticket_id);
+}
+
+ResultOr<bool> ShardedTable::has_generated_ticket_id_expired(GeneratedTicketID generated_ticket_id) const
+{
+    if (generated_ticket_id.id == invalid_ticket_id)
+        return Result(Result::IdInvalid);
+
+    const std::scoped_lock lock(m_insertion_mutex);
+    if (generated_ticket_id.generation == m_ticket_id_generation)
+        return false;
+
+    return true;
+}
+
+ResultOr<ShardedTable::GeneratedTicketID> ShardedTable::generate_ticket_id()
+{
+    constexpr u64 ticket_id_low_range = 1;
+    // NOTE: See Table::generate_ticket_id() for the explanation of the range.
+    constexpr u64 ticket_id_high_range = 36ull * 36ull * 36ull * 36ull * 36ull;
+
+    const std::scoped_lock lock(m_insertion_mutex);
+
+    TicketID ticket_id;
+    bool ticket_was_generated = false;
+
+    for (u32 try_counter = 0; !ticket_was_generated && (try_counter < 512); ++try_counter)
+    {
+        TRY_ASSIGN(ticket_id, generate_random_unsigned(ticket_id_low_range, ticket_id_high_range));
+        TRY_ASSIGN(const bool ticket_id_is_used, is_ticket_id_valid(ticket_id));
+        if (!ticket_id_is_used)
+            ticket_was_generated = true;
+    }
+
+    if (!ticket_was_generated)
+        return Result(Result::IdGenerationFailed);
+
+    TRY(safe_unsigned_increment(m_ticket_id_generation))
+    return GeneratedTicketID(ticket_id, m_ticket_id_generation);
+}
+
+ResultOr<void> ShardedTable::insert_entry_with_ticket_id(TicketID ticket_id, TableEntry entry)
+{
+    const std::scoped_lock lock(m_insertion_mutex);
+    TRY(insert_entry_with_ticket_id_unlocked(ticket_id, std::move(entry)));
+    return {};
+}
+
+ResultOr<void> ShardedTable::insert_entry_with_ticket_id(GeneratedTicketID generated_ticket_id, TableEntry entry)
+{
+    if (generated_ticket_id.id == invalid_ticket_id)
+        return Result(Result::IdInvalid);
+
+    const std::scoped_lock lock(m_insertion_mutex);
+    if (generated_ticket_id.generation != m_ticket_id_generation)
+        return Result(Result::IdExpired);
+
+    TRY(insert_entry_with_ticket_id_unlocked(generated_ticket_id.id, std::move(entry)));
+    return {};
+}
+
+ResultOr<TicketID> ShardedTable::insert_entry(TableEntry entry)
+{
+    TRY_ASSIGN(const GeneratedTicketID generated_ticket_id, generate_ticket_id());
+    TRY(insert_entry_with_ticket_id(generated_ticket_id, std::move(entry)));
+    return generated_ticket_id.id;
+}
+
+ResultOr<void> ShardedTable::insert_entry_with_ticket_id_unlocked(TicketID ticket_id, TableEntry entry)
+{
+    TRY_ASSIGN(const bool ticket_id_is_used, is_ticket_id_valid(ticket_id));
+    if (ticket_id_is_used)
+        return Result(Result::IdAlreadyExists);
+
+    // NOTE: The shard that will own the entry only checks its own entries for duplicates, so the other shards
+    //       must be checked here. The insertion lock guarantees that no other entry is inserted meanwhile.
+    TRY(Table::format_entry(entry));
+    for (const OwnPtr<Table>& shard : m_shards)
+    {
+        const std::shared_lock shard_lock(shard->m_mutex);
+        TRY_ASSIGN(const bool entry_already_exists, shard->similar_entry_already_exists(entry));
+        if (entry_already_exists)
+            return Result(Result::EntryAlreadyExists);
+    }
+
+    TRY(get_shard(ticket_id).insert_entry_with_ticket_id(ticket_id, std::move(entry)));
+    TRY(safe_unsigned_increment(m_ticket_id_generation));
+    return {};
+}
+
+ResultOr<void> ShardedTable::remove_ticket(TicketID ticket_id)
+{
+    TRY(get_shard(ticket_id).remove_ticket(ticket_id));
+    return {};
+}
+
+ResultOr<usize> ShardedTable::entry_count() const
+{
+    usize entry_count = 0;
+    for (const OwnPtr<Table>& shard : m_shards)
+    {
+        TRY_ASSIGN(const usize shard_entry_count, shard->entry_count());
+        entry_count += shard_entry_count;
+    }
+
+    return entry_count;
+}
+
+ResultOr<const TableEntry&> ShardedTable::get_entry(TicketID ticket_id) const
+{
+    return get_shard(ticket_id).get_entry(ticket_id);
+}
+
+ResultOr<Vector<TicketID>> ShardedTable::find_ticket_id_by_name(StringView first_name, StringView last_name) const
+{
+    Vector<TicketID> ticket_ids;
+    for (const OwnPtr<Table>& shard : m_shards)
+    {
+        TRY_ASSIGN(const Vector<TicketID> shard_ticket_ids, shard->find_ticket_id_by_name(first_name, last_name));
+        ticket_ids.insert(ticket_ids.end(), shard_ticket_ids.begin(), shard_ticket_ids.end());
+    }
+
+    // Keep the same order as a regular table would.
+    std::sort(ticket_ids.begin(), ticket_ids.end());
+    return ticket_ids;
+}
+
+ResultOr<Vector<TableNameMatch>>
+ShardedTable::find_similar_names(StringView last_name, StringView first_name, usize max_match_count) const
+{
+    // NOTE: The best matches of the whole table are among the best matches of the shards.
+    Vector<TableNameMatch> matches;
+    for (const OwnPtr<Table>& shard : m_shards)
+    {
+        TRY_ASSIGN(
+            Vector<TableNameMatch> shard_matches,
+            shard->find_similar_names(last_name, first_name, max_match_count)
+        );
+        std::move(shard_matches.begin(), shard_matches.end(), std::back_inserter(matches));
+    }
+
+    std::sort(
+        matches.begin(),
+        matches.end(),
+        [](const TableNameMatch& a, const TableNameMatch& b)
+        {
+            if (a.distance != b.distance)
+                return a.distance < b.distance;
+            return a.ticket_id < b.ticket_id;
+        }
+    );
+    if (matches.size() > max_match_count)
+        matches.erase(matches.begin() + static_cast<i64>(max_match_count), matches.end());
+
+    return matches;
+}
+
+ResultOr<void> ShardedTable::increment_ticket_scan_count(TicketID ticket_id)
+{
+    TRY(get_shard(ticket_id).increment_ticket_scan_count(ticket_id));
+    return {};
+}
+
+ResultOr<TableEntry> ShardedTable::scan_ticket(TicketID ticket_id)
+{
+    return get_shard(ticket_id).scan_ticket(ticket_id);
+}
+
+usize ShardedTable::get_shard_index(TicketID ticket_id) const
+{
+    // NOTE: Ticket IDs are generated randomly, but they are also read from files that might have been edited by
+    //       hand. Mixing the bits (Fibonacci hashing) keeps the shards balanced even for sequential IDs.
+    const u64 hash = static_cast<u64>(ticket_id) * 0x9E3779B97F4A7C15ull;
+    return static_cast<usize>((hash >> 32) % m_shards.size());
+}
+
+} // namespace Octopus
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Table.h"
+
+namespace Octopus
+{
+
+///
+/// Table that partitions its entries into multiple independent shards, based on the hash of their ticket ID.
+/// Each shard is a regular table with its own lock, so operations on tickets that live in different shards never
+/// contend with each other. The public interface is the same as the interface of the table, except that entries
+/// can't be changed in place.
+///
+/// Two entries of the same person can't live in the same table, regardless of their shards. Because of this, all
+/// insertions are serialized by a separate lock, which is never taken when scanning or reading tickets.
+///
+class ShardedTable
+{
+public:
+    OCT_NONCOPYABLE(ShardedTable)
+    OCT_NONMOVABLE(ShardedTable)
+    ~ShardedTable() = default;
+
+    using GeneratedTicketID = Table::GeneratedTicketID;
+
+    static constexpr usize default_shard_count = 16;
+
+public:
+    static ResultOr<OwnPtr<ShardedTable>> create_new(usize shard_count = default_shard_count);
+    static ResultOr<OwnPtr<ShardedTable>>
+    create_from_file(const String& filepath, usize shard_count = default_shard_count);
+
+    /// The entries of all shards are written to a single database file, sorted by their ticket ID. The file is
+    /// identical to the one that would be written by a table that contains the same entries.
+    ResultOr<void> save_to_file(const String& filepath) const;
+
+    NODISCARD ALWAYS_INLINE Base36CheckCharacter ticket_code_check_character() const
+    {
+        return m_ticket_code_check_character.load(std::memory_order_relaxed);
+    }
+    void set_ticket_code_check_character(Base36CheckCharacter check_character);
+
+    NODISCARD String format_ticket_code(TicketID ticket_id) const;
+    ResultOr<TicketID> parse_ticket_code(StringView ticket_code) const;
+
+public:
+    ResultOr<bool> is_ticket_id_valid(TicketID ticket_id) const;
+    ResultOr<bool> has_generated_ticket_id_expired(GeneratedTicketID generated_ticket_id) const;
+    ResultOr<GeneratedTicketID> generate_ticket_id();
+
+    ResultOr<void> insert_entry_with_ticket_id(TicketID ticket_id, TableEntry entry);
+    ResultOr<void> insert_entry_with_ticket_id(GeneratedTicketID generated_ticket_id, TableEntry entry);
+    ResultOr<TicketID> insert_entry(TableEntry entry);
+
+    ResultOr<void> remove_ticket(TicketID ticket_id);
+
+    ResultOr<usize> entry_count() const;
+    ResultOr<const TableEntry&> get_entry(TicketID ticket_id) const;
+    ResultOr<Vector<TicketID>> find_ticket_id_by_name(StringView first_name, StringView last_name) const;
+
+    /// Every shard is searched separately, and their matches are merged.
+    ResultOr<Vector<TableNameMatch>>
+    find_similar_names(StringView last_name, StringView first_name, usize max_match_count) const;
+
+    /// The shards are iterated one after another, and only the shard that is currently iterated is locked.
+    /// The entries are sorted by their ticket ID only within a shard.
+    template<typename Func>
+    ALWAYS_INLINE ResultOr<void> iterate_over_entries(Func callback) const
+    {
+        bool should_break = false;
+        for (const OwnPtr<Table>& shard : m_shards)
+        {
+            TRY(shard->iterate_over_entries(
+                [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+                {
+                    TRY_ASSIGN(const IterationDecision decision, callback(ticket_id, entry));
+                    should_break = (decision == IterationDecision::Break);
+                    return decision;
+                }
+            ));
+
+            if (should_break)
+                break;
+        }
+
+        return {};
+    }
+
+    ResultOr<void> increment_ticket_scan_count(TicketID ticket_id);
+    ResultOr<TableEntry> scan_ticket(TicketID ticket_id);
+
+    NODISCARD ALWAYS_INLINE usize shard_count() const { return m_shards.size(); }
+
+private:
+    ShardedTable() = default;
+
+    NODISCARD usize get_shard_index(TicketID ticket_id) const;
+    NODISCARD ALWAYS_INLINE Table& get_shard(TicketID ticket_id) { return *m_shards[get_shard_index(ticket_id)]; }
+    NODISCARD ALWAYS_INLINE const Table& get_shard(TicketID ticket_id) const
+    {
+        return *m_shards[get_shard_index(ticket_id)];
+    }
+
+    ResultOr<void> insert_entry_with_ticket_id_unlocked(TicketID ticket_id, TableEntry entry);
+
+private:
+    Vector<OwnPtr<Table>> m_shards;
+
+    /// Serializes the insertions and guards the ticket ID generation.
+    mutable std::mutex m_insertion_mutex;
+    u64 m_ticket_id_generation = invalid_ticket_generation;
+
+    std::atomic<Base36CheckCharacter> m_ticket_code_check_character = Base36CheckCharacter::None;
+};
+
+} // namespace Octopus
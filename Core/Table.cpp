@@ -4,19 +4,17 @@
  */
 
 #include "Table.h"
+#include "Checksum.h"
 #include "MathUtils.h"
+#include "NameFormat.h"
+#include "NameTrigramIndex.h"
+#include "TableArchive.h"
 
 #define YAML_CPP_STATIC_DEFINE
 #include "yaml-cpp/yaml.h"
 
 #include <format>
 
-#define ALLOWED_GRADE_LOW  9
-#define ALLOWED_GRADE_HIGH 12
-
-#define ALLOWED_GRADE_ID_LOW  'A'
-#define ALLOWED_GRADE_ID_HIGH 'F'
-
 namespace Octopus
 {
 
@@ -26,8 +24,12 @@ ResultOr<OwnPtr<Table>> Table::create_new()
     if (!table)
         return Result(Result::OutOfMemory);
 
+    table->m_storage = std::make_shared<TableStorage>();
+    if (!table->m_storage)
+        return Result(Result::OutOfMemory);
+
+    table->rebuild_ticket_id_filter();
     table->m_ticket_id_generation = 1;
-    table->m_entries.clear();
     return table;
 }
 
@@ -49,26 +51,13 @@ ALWAYS_INLINE ResultOr<YAML::Node> get_yaml_node(YAML::Node& node, StringView fi
     return field_node;
 }
 
-ResultOr<OwnPtr<Table>> Table::create_from_file(const String& filepath)
+static ResultOr<void>
+load_table_entries(YAML::Node& table_entries, Vector<LoadedTableEntry>& out_entries, bool entries_are_verified)
 {
-    TRY_ASSIGN(OwnPtr<Table> table, Table::create_new());
-
-    const std::ifstream input(filepath);
-    if (!input.is_open())
-        return Result(Result::InvalidFilepath);
-    std::stringstream buffer;
-    buffer << input.rdbuf();
-
-    YAML::Node table_data = YAML::Load(buffer.str());
-    if (!table_data)
-        return Result(Result::InvalidYAML);
-
-    TRY_ASSIGN(auto table_info, get_yaml_node<YAML::Node>(table_data, "info"));
-    TRY_ASSIGN(auto table_entries, get_yaml_node<YAML::Node>(table_data, "entries"));
-
     if (!table_entries.IsSequence())
         return Result(Result::InvalidYAML);
 
+    out_entries.reserve(out_entries.size() + table_entries.size());
     for (auto table_entry : table_entries)
     {
         TRY_ASSIGN(auto ticket_id_string, get_yaml_node<String>(table_entry, "ticket_id"));
@@ -82,129 +71,620 @@ ResultOr<OwnPtr<Table>> Table::create_from_file(const String& filepath)
         TRY_ASSIGN(auto metadata_scan_count, get_yaml_node<u32>(metadata, "scan_count"));
         TRY_ASSIGN(auto metadata_last_scan_date, get_yaml_node<String>(metadata, "last_scan_date"));
 
-        TableEntry entry;
-        entry.first_name = first_name;
-        entry.last_name = last_name;
+        // NOTE: The grade is checked before it is truncated, so that a grade such as 265 isn't read as 9.
+        if (grade > ALLOWED_GRADE_HIGH)
+            return Result(Result::InvalidEntryField);
+
+        LoadedTableEntry& loaded_entry = out_entries.emplace_back();
+        TableEntry& entry = loaded_entry.entry;
+        entry.first_name = std::move(first_name);
+        entry.last_name = std::move(last_name);
         entry.grade = static_cast<u8>(grade);
         entry.grade_id = grade_id;
 
         entry.metadata.flags = metadata_flags;
         entry.metadata.scan_count = metadata_scan_count;
-        entry.metadata.last_scan_date = std::move(metadata_last_scan_date);
+        TRY_ASSIGN(entry.metadata.last_scan_timestamp, parse_scan_timestamp(metadata_last_scan_date));
 
-        TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_id_string));
-        TRY(table->insert_entry_with_ticket_id(ticket_id, entry));
+        TRY_ASSIGN(loaded_entry.ticket_id, transform_from_base_36<u64>(ticket_id_string));
+        // The entries of a verified file were formatted before they were saved, so their names aren't formatted
+        // again. Their class and the characters of their names are still checked, as the checksum only detects
+        // accidental changes of the file.
+        if (!entries_are_verified)
+        {
+            TRY(Table::format_entry(entry));
+        }
+        else if (!Table::is_class_valid(entry.grade, entry.grade_id) || !are_name_characters_valid(entry.first_name) ||
+                 !are_name_characters_valid(entry.last_name))
+        {
+            return Result(Result::InvalidEntryField);
+        }
     }
 
+    return {};
+}
+
+/// The names of the ticket code formats, as written in the info of the database file.
+static constexpr StringView s_plain_ticket_code_format_name = "plain";
+static constexpr StringView s_luhn_mod_36_ticket_code_format_name = "luhn_mod_36";
+
+NODISCARD static StringView get_ticket_code_format_name(Base36CheckCharacter check_character)
+{
+    switch (check_character)
+    {
+        case Base36CheckCharacter::None: return s_plain_ticket_code_format_name;
+        case Base36CheckCharacter::LuhnMod36: return s_luhn_mod_36_ticket_code_format_name;
+    }
+
+    return s_plain_ticket_code_format_name;
+}
+
+static ResultOr<Base36CheckCharacter> parse_ticket_code_format_name(StringView name)
+{
+    if (name == s_plain_ticket_code_format_name)
+        return Base36CheckCharacter::None;
+    if (name == s_luhn_mod_36_ticket_code_format_name)
+        return Base36CheckCharacter::LuhnMod36;
+    return Result(Result::InvalidYAML);
+}
+
+/// The location of the block sequence that follows the 'entries:' key of the database file.
+struct TableEntriesLayout
+{
+    /// The byte range of the sequence items, excluding the line of the key.
+    usize begin_offset = 0;
+    usize end_offset = 0;
+    /// The offsets where each item of the sequence begins.
+    Vector<usize> item_offsets;
+};
+
+/// Finds the items of the entries sequence without parsing them, by looking at the beginning of each line.
+/// Returns false if the sequence isn't written in the block style produced by Table::save_to_file(), in which case
+/// the file can't be split.
+static bool find_table_entries_layout(StringView text, TableEntriesLayout& out_layout)
+{
+    constexpr StringView entries_key = "entries:";
+
+    usize key_offset = 0;
+    while (true)
+    {
+        key_offset = text.find(entries_key, key_offset);
+        if (key_offset == StringView::npos)
+            return false;
+        if (key_offset == 0 || text[key_offset - 1] == '\n')
+            break;
+        key_offset += entries_key.size();
+    }
+
+    const usize key_line_end = text.find('\n', key_offset);
+    if (key_line_end == StringView::npos)
+        return false;
+
+    // Nothing but whitespace is allowed after the key, otherwise the sequence is written in the flow style.
+    for (usize offset = key_offset + entries_key.size(); offset < key_line_end; ++offset)
+    {
+        if (text[offset] != ' ' && text[offset] != '\r')
+            return false;
+    }
+
+    out_layout.begin_offset = key_line_end + 1;
+    out_layout.end_offset = text.size();
+    out_layout.item_offsets.clear();
+
+    StringView item_prefix;
+    for (usize line_offset = out_layout.begin_offset; line_offset < text.size();)
+    {
+        usize line_end = text.find('\n', line_offset);
+        if (line_end == StringView::npos)
+            line_end = text.size();
+        const StringView line = text.substr(line_offset, line_end - line_offset);
+
+        const usize indentation = line.find_first_not_of(' ');
+        const bool is_blank =
+            (indentation == StringView::npos) || line[indentation] == '\r' || line[indentation] == '#';
+
+        if (!is_blank)
+        {
+            if (item_prefix.empty())
+            {
+                // The first item determines the indentation of the sequence.
+                if (line[indentation] != '-')
+                    return false;
+                item_prefix = line.substr(0, indentation + 1);
+            }
+
+            if (line.starts_with(item_prefix))
+            {
+                const usize after_dash = item_prefix.size();
+                if (after_dash == line.size() || line[after_dash] == ' ' || line[after_dash] == '\r')
+                    out_layout.item_offsets.push_back(line_offset);
+            }
+            else if (indentation == 0)
+            {
+                // A line that is less indented than the items ends the sequence.
+                out_layout.end_offset = line_offset;
+                break;
+            }
+        }
+
+        line_offset = line_end + 1;
+    }
+
+    return !out_layout.item_offsets.empty();
+}
+
+/// Splitting the entries into chunks smaller than this isn't worth the cost of starting a thread.
+static constexpr usize min_table_entries_chunk_size = 256 * 1024;
+
+ResultOr<OwnPtr<Table>> Table::create_from_file(const String& filepath)
+{
+    TRY_ASSIGN(OwnPtr<Table> table, Table::create_new());
+
+    std::ifstream input(filepath, std::ios::binary | std::ios::ate);
+    if (!input.is_open())
+        return Result(Result::InvalidFilepath);
+
+    String text;
+    text.resize(static_cast<usize>(input.tellg()));
+    input.seekg(0);
+    input.read(text.data(), static_cast<std::streamsize>(text.size()));
+
+    // NOTE: The blocks of an archive are verified by their checksums when they are decoded, so its entries are
+    //       trusted like the entries of a verified database file. Their classes and the characters of their names
+    //       are still checked while they are decoded.
+    if (TableArchive::has_archive_signature(text))
+    {
+        Vector<Vector<LoadedTableEntry>> chunk_entries;
+        Base36CheckCharacter ticket_code_check_character;
+        TRY(TableArchive::load_entries(text, chunk_entries, ticket_code_check_character));
+        table->set_ticket_code_check_character(ticket_code_check_character);
+        TRY(table->insert_loaded_entries(chunk_entries, true));
+        table->m_is_loaded_file_verified = true;
+        return table;
+    }
+
+    TableEntriesLayout layout;
+    const bool can_split_entries = find_table_entries_layout(text, layout);
+    const usize entries_size = layout.end_offset - layout.begin_offset;
+
+    usize chunk_count = 1;
+    if (can_split_entries)
+    {
+        const usize hardware_thread_count = std::max<usize>(std::thread::hardware_concurrency(), 1);
+        chunk_count = std::clamp<usize>(entries_size / min_table_entries_chunk_size, 1, hardware_thread_count);
+        chunk_count = std::min(chunk_count, layout.item_offsets.size());
+    }
+
+    // NOTE: The entries are parsed separately from the rest of the file. The sequence is cut out of the document,
+    //       leaving the 'entries:' key with an empty value, and each chunk of items is parsed as its own document.
+    YAML::Node table_data;
+    if (can_split_entries)
+        table_data = YAML::Load(text.substr(0, layout.begin_offset) + text.substr(layout.end_offset));
+    else
+        table_data = YAML::Load(text);
+    if (!table_data)
+        return Result(Result::InvalidYAML);
+
+    TRY_ASSIGN(auto table_info, get_yaml_node<YAML::Node>(table_data, "info"));
     TRY_ASSIGN(auto ticket_count, get_yaml_node<u32>(table_info, "tickets"));
-    if (ticket_count != table->m_entries.size())
+
+    // The format of the ticket codes is optional, as older database files don't specify it.
+    if (table_info["ticket_codes"])
+    {
+        TRY_ASSIGN(const auto ticket_codes_name, get_yaml_node<String>(table_info, "ticket_codes"));
+        TRY_ASSIGN(const auto ticket_code_check_character, parse_ticket_code_format_name(ticket_codes_name));
+        table->set_ticket_code_check_character(ticket_code_check_character);
+    }
+
+    // NOTE: A file whose entries match the checksum written by save_to_file() is trusted, so its entries are only
+    //       parsed and not validated again. Any other file, including one that was edited by hand, goes through the
+    //       full validation.
+    bool entries_are_verified = false;
+    if (can_split_entries && table_info["entries_crc32c"])
+    {
+        TRY_ASSIGN(const auto entries_crc32c, get_yaml_node<u32>(table_info, "entries_crc32c"));
+        const StringView entries_text = StringView(text).substr(layout.begin_offset, entries_size);
+        entries_are_verified = (compute_crc32c(entries_text) == entries_crc32c);
+    }
+    table->m_is_loaded_file_verified = entries_are_verified;
+
+    Vector<Vector<LoadedTableEntry>> chunk_entries(chunk_count);
+    if (!can_split_entries)
+    {
+        TRY_ASSIGN(auto table_entries, get_yaml_node<YAML::Node>(table_data, "entries"));
+        TRY(load_table_entries(table_entries, chunk_entries[0], entries_are_verified));
+    }
+    else
+    {
+        Vector<usize> chunk_offsets;
+        chunk_offsets.reserve(chunk_count + 1);
+        usize item_index = 0;
+        for (usize chunk_index = 0; chunk_index < chunk_count; ++chunk_index)
+        {
+            // Every chunk starts at the first item that begins after its fair share of the bytes.
+            const usize target_offset = layout.begin_offset + (entries_size / chunk_count) * chunk_index;
+            while (item_index + 1 < layout.item_offsets.size() && layout.item_offsets[item_index] < target_offset)
+                ++item_index;
+            chunk_offsets.push_back(layout.item_offsets[item_index]);
+        }
+        chunk_offsets.push_back(layout.end_offset);
+
+        Vector<Optional<Result>> chunk_results(chunk_count);
+        const auto load_chunk = [&](usize chunk_index)
+        {
+            const usize chunk_begin = chunk_offsets[chunk_index];
+            const usize chunk_end = chunk_offsets[chunk_index + 1];
+            if (chunk_begin == chunk_end)
+                return;
+
+            String chunk_text = "entries:\n";
+            chunk_text.append(text, chunk_begin, chunk_end - chunk_begin);
+            YAML::Node chunk_data = YAML::Load(chunk_text);
+
+            auto table_entries = chunk_data["entries"];
+            auto result = load_table_entries(table_entries, chunk_entries[chunk_index], entries_are_verified);
+            if (result.is_result())
+                chunk_results[chunk_index] = result.release_result();
+        };
+
+        // The calling thread loads the first chunk, while the others are loaded by worker threads.
+        Vector<std::thread> workers;
+        workers.reserve(chunk_count - 1);
+        for (usize chunk_index = 1; chunk_index < chunk_count; ++chunk_index)
+            workers.emplace_back(load_chunk, chunk_index);
+        load_chunk(0);
+        for (std::thread& worker : workers)
+            worker.join();
+
+        for (const Optional<Result>& chunk_result : chunk_results)
+        {
+            if (chunk_result.has_value())
+                return chunk_result.value();
+        }
+    }
+
+    TRY(table->insert_loaded_entries(chunk_entries, entries_are_verified));
+
+    if (ticket_count != table->m_storage->entries.size())
         return Result(Result::CorruptedTable);
 
     return table;
 }
 
+ResultOr<void> Table::insert_loaded_entries(Span<Vector<LoadedTableEntry>> chunk_entries, bool entries_are_verified)
+{
+    TRY(detach_storage());
+    auto& table_entries = m_storage->entries;
+
+    usize entry_count = 0;
+    for (const Vector<LoadedTableEntry>& entries : chunk_entries)
+        entry_count += entries.size();
+
+    // NOTE: Checking every entry against all the others, like similar_entry_already_exists() does, is quadratic.
+    //       All the entries are known up front, so the duplicates are found with a hash set instead.
+    HashSet<String> entry_keys;
+    const auto get_entry_key = [](const TableEntry& entry) -> String
+    {
+        String key;
+        key.reserve(entry.first_name.size() + entry.last_name.size() + 4);
+        key.append(entry.first_name).push_back('\0');
+        key.append(entry.last_name).push_back('\0');
+        key.push_back(static_cast<char>(entry.grade));
+        key.push_back(entry.grade_id);
+        return key;
+    };
+
+    if (!entries_are_verified)
+    {
+        entry_keys.reserve(table_entries.size() + entry_count);
+        for (const auto& [ticket_id, entry] : table_entries)
+            entry_keys.insert(get_entry_key(entry));
+    }
+
+    for (Vector<LoadedTableEntry>& entries : chunk_entries)
+    {
+        for (LoadedTableEntry& loaded_entry : entries)
+        {
+            if (!entries_are_verified && !entry_keys.insert(get_entry_key(loaded_entry.entry)).second)
+                return Result(Result::EntryAlreadyExists);
+
+            // The entries are usually sorted by their ticket ID, so they are inserted at the end of the map.
+            const auto previous_size = table_entries.size();
+            const auto entry_it =
+                table_entries.emplace_hint(table_entries.end(), loaded_entry.ticket_id, std::move(loaded_entry.entry));
+            if (table_entries.size() == previous_size)
+                return Result(Result::IdAlreadyExists);
+            m_statistics.add_entry(entry_it->second);
+        }
+    }
+
+    // NOTE: The final number of entries is known, so the filter is built once instead of growing along the way.
+    rebuild_ticket_id_filter();
+    TRY(safe_unsigned_increment(m_ticket_id_generation));
+    return {};
+}
+
 ResultOr<void> Table::save_to_file(const String& filepath) const
 {
-    YAML::Emitter emitter;
-    emitter << YAML::BeginMap;
+    // NOTE: Writing the file can take a long time, so it is done without holding the lock of the table.
+    const TableSnapshot table_snapshot = snapshot();
+    TRY(table_snapshot.save_to_file(filepath));
+    return {};
+}
 
-    // Information about the table.
-    emitter << YAML::Key << "info" << YAML::BeginMap;
-    emitter << YAML::Key << "name" << YAML::Value << "CNGC-BB-2024";
-    emitter << YAML::Key << "tickets" << YAML::Value << m_entries.size();
-    emitter << YAML::EndMap;
+TableSnapshot Table::snapshot() const
+{
+    const std::shared_lock lock(m_mutex);
+    return TableSnapshot(m_storage, ticket_code_check_character());
+}
+
+ResultOr<void> Table::detach_storage()
+{
+    if (m_storage.use_count() == 1)
+    {
+        // The entries are about to be modified in place, which invalidates their index.
+        m_storage->name_index.reset();
+        m_storage->name_trigram_index.reset();
+        return {};
+    }
 
-    emitter << YAML::Key << "entries" << YAML::BeginSeq;
+    m_storage = std::make_shared<TableStorage>(m_storage->entries);
+    if (!m_storage)
+        return Result(Result::OutOfMemory);
+    return {};
+}
 
-    for (const auto& [ticket_id, entry] : m_entries)
+void Table::add_ticket_id_to_filter(TicketID ticket_id)
+{
+    // The removed tickets are still counted, so a table that keeps changing eventually drops them from the filter.
+    if (m_ticket_id_filter.key_count() >= m_ticket_id_filter.key_capacity())
     {
-        TRY(entry.check_corrupted(Result::CorruptedTable));
-
-        emitter << YAML::BeginMap;
-        emitter << YAML::Key << "ticket_id" << YAML::Value << transform_to_base_36(ticket_id);
-        emitter << YAML::Key << "first_name" << YAML::Value << entry.first_name;
-        emitter << YAML::Key << "last_name" << YAML::Value << entry.last_name;
-        emitter << YAML::Key << "grade" << YAML::Value << static_cast<u32>(entry.grade);
-        emitter << YAML::Key << "grade_id" << YAML::Value << entry.grade_id;
-
-        emitter << YAML::Key << "metadata" << YAML::BeginMap;
-        emitter << YAML::Key << "flags" << YAML::Value << static_cast<u32>(entry.metadata.flags);
-        emitter << YAML::Key << "scan_count" << YAML::Value << static_cast<u32>(entry.metadata.scan_count);
-
-        if (entry.metadata.last_scan_date[0])
-            emitter << YAML::Key << "last_scan_date" << YAML::Value << entry.metadata.last_scan_date;
-        else
-            emitter << YAML::Key << "last_scan_date" << YAML::Value << "N/A";
-
-        emitter << YAML::EndMap; // Metadata map.
-        emitter << YAML::EndMap; // Ticket entry map.
+        rebuild_ticket_id_filter();
+        return;
     }
 
-    emitter << YAML::EndSeq;
-    emitter << YAML::EndMap;
+    m_ticket_id_filter.insert(ticket_id);
+}
 
-    std::ofstream output(filepath);
-    if (!output.is_open())
-        return Result(Result::InvalidFilepath);
-    output << emitter.c_str();
+void Table::rebuild_ticket_id_filter()
+{
+    constexpr usize minimum_key_capacity = 1024;
+    m_ticket_id_filter.reset(std::max(2 * m_storage->entries.size(), minimum_key_capacity));
+    for (const auto& [ticket_id, entry] : m_storage->entries)
+        m_ticket_id_filter.insert(ticket_id);
+}
+
+ResultOr<RefPtr<const TableEntryIndex>> TableSnapshot::get_name_index() const
+{
+    const std::scoped_lock<std::mutex> lock(m_storage->name_index_mutex);
+    if (m_storage->name_index)
+        return m_storage->name_index;
+
+    RefPtr<TableEntryIndex> name_index = std::make_shared<TableEntryIndex>();
+    if (!name_index)
+        return Result(Result::OutOfMemory);
+
+    name_index->reserve(m_storage->entries.size());
+    for (const auto& table_entry : m_storage->entries)
+        name_index->push_back(&table_entry);
+
+    // NOTE: The entries are already sorted by their ticket ID, so a stable sort keeps the entries with identical
+    //       names in that order.
+    std::stable_sort(
+        name_index->begin(),
+        name_index->end(),
+        [](const TableEntryMap::value_type* a, const TableEntryMap::value_type* b) -> bool
+        {
+            if (const i32 comparison = a->second.last_name.compare(b->second.last_name); comparison != 0)
+                return comparison < 0;
+            return a->second.first_name < b->second.first_name;
+        }
+    );
+
+    m_storage->name_index = name_index;
+    return m_storage->name_index;
+}
+
+ResultOr<RefPtr<const NameTrigramIndex>> TableSnapshot::get_name_trigram_index() const
+{
+    const std::scoped_lock<std::mutex> lock(m_storage->name_trigram_index_mutex);
+    if (m_storage->name_trigram_index)
+        return m_storage->name_trigram_index;
+
+    TRY_ASSIGN(m_storage->name_trigram_index, NameTrigramIndex::create(m_storage->entries));
+    return m_storage->name_trigram_index;
+}
+
+ResultOr<const TableEntry&> TableSnapshot::get_entry(TicketID ticket_id) const
+{
+    auto entry_it = m_storage->entries.find(ticket_id);
+    if (entry_it == m_storage->entries.end())
+        return Result(Result::IdNotFound);
+
+    return entry_it->second;
+}
+
+ResultOr<TicketID> TableSnapshot::parse_ticket_code(StringView ticket_code) const
+{
+    TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_code, m_ticket_code_check_character));
+    return ticket_id;
+}
+
+ResultOr<void> TableSnapshot::save_to_file(const String& filepath) const
+{
+    Vector<Table::EntryReference> entries;
+    entries.reserve(m_storage->entries.size());
+    for (const auto& [ticket_id, entry] : m_storage->entries)
+        entries.push_back({ ticket_id, &entry });
 
+    TRY(Table::save_entries_to_file(filepath, entries, m_ticket_code_check_character));
     return {};
 }
 
-static ResultOr<void> format_name_string(String& name)
+static ResultOr<void> emit_table_entry(YAML::Emitter& emitter, TicketID ticket_id, const TableEntry& entry)
 {
-    for (usize index = 0; index < name.size(); ++index)
-        name[index] = static_cast<char>(std::tolower(name[index]));
+    emitter << YAML::BeginMap;
+    emitter << YAML::Key << "ticket_id" << YAML::Value << transform_to_base_36(ticket_id);
+    emitter << YAML::Key << "first_name" << YAML::Value << entry.first_name;
+    emitter << YAML::Key << "last_name" << YAML::Value << entry.last_name;
+    emitter << YAML::Key << "grade" << YAML::Value << static_cast<u32>(entry.grade);
+    emitter << YAML::Key << "grade_id" << YAML::Value << entry.grade_id;
+
+    emitter << YAML::Key << "metadata" << YAML::BeginMap;
+    emitter << YAML::Key << "flags" << YAML::Value << static_cast<u32>(entry.metadata.flags);
+    emitter << YAML::Key << "scan_count" << YAML::Value << entry.metadata.scan_count.load();
+
+    TRY_ASSIGN(const String last_scan_date, format_scan_timestamp(entry.metadata.last_scan_timestamp));
+    emitter << YAML::Key << "last_scan_date" << YAML::Value << last_scan_date;
 
-    bool character_must_be_uppercase = true;
-    char last_character = '-';
+    emitter << YAML::EndMap; // Metadata map.
+    emitter << YAML::EndMap; // Ticket entry map.
+    return {};
+}
 
-    String formatted_name = String();
-    for (usize index = 0; index < name.size(); ++index)
+/// Emitting fewer entries than this on a separate thread isn't worth the cost of starting the thread.
+static constexpr usize min_table_entries_chunk_entry_count = 4096;
+/// The entries are split into the same chunks on every machine, and the threads divide the chunks between them.
+static constexpr usize max_table_entries_chunk_count = 64;
+
+ResultOr<void> Table::save_entries_to_file(
+    const String& filepath,
+    Span<const EntryReference> entries,
+    Base36CheckCharacter ticket_code_check_character
+)
+{
+    const usize hardware_thread_count = std::max<usize>(std::thread::hardware_concurrency(), 1);
+    const usize chunk_count =
+        std::clamp<usize>(entries.size() / min_table_entries_chunk_entry_count, 1, max_table_entries_chunk_count);
+    const usize thread_count = std::min(chunk_count, hardware_thread_count);
+
+    // Information about the table.
+    YAML::Emitter emitter;
+    emitter << YAML::BeginMap;
+    emitter << YAML::Key << "info" << YAML::BeginMap;
+    emitter << YAML::Key << "name" << YAML::Value << "CNGC-BB-2024";
+    emitter << YAML::Key << "tickets" << YAML::Value << entries.size();
+    // NOTE: The key is omitted for plain codes, so the files of existing events stay the same.
+    if (ticket_code_check_character != Base36CheckCharacter::None)
     {
-        auto character = name[index];
-        if (character != '-' && character != ' ' && !std::isalpha(character))
-            return Result(Result::InvalidString);
+        emitter << YAML::Key << "ticket_codes" << YAML::Value
+                << String(get_ticket_code_format_name(ticket_code_check_character));
+    }
 
-        if (std::isalpha(character))
+    if (entries.empty())
+    {
+        emitter << YAML::EndMap;
+        emitter << YAML::Key << "entries" << YAML::BeginSeq << YAML::EndSeq;
+        emitter << YAML::EndMap;
+
+        std::ofstream output(filepath, std::ios::binary);
+        if (!output.is_open())
+            return Result(Result::InvalidFilepath);
+        output << emitter.c_str();
+        return {};
+    }
+
+    // NOTE: Every chunk of entries is emitted as the 'entries' sequence of its own document.
+    //       Without the line of the key, the output of each chunk is exactly the text that a single emitter would
+    //       produce for those entries, so the chunks are written one after another, separated by newlines.
+    constexpr StringView entries_key_line = "entries:\n";
+
+    Vector<YAML::Emitter> chunk_emitters(chunk_count);
+    Vector<Optional<Result>> chunk_results(chunk_count);
+    const auto emit_chunk = [&](usize chunk_index)
+    {
+        const usize chunk_begin = (entries.size() * chunk_index) / chunk_count;
+        const usize chunk_end = (entries.size() * (chunk_index + 1)) / chunk_count;
+
+        YAML::Emitter& chunk_emitter = chunk_emitters[chunk_index];
+        chunk_emitter << YAML::BeginMap;
+        chunk_emitter << YAML::Key << "entries" << YAML::BeginSeq;
+        for (usize entry_index = chunk_begin; entry_index < chunk_end; ++entry_index)
         {
-            if (character_must_be_uppercase)
+            const auto& [ticket_id, entry] = entries[entry_index];
+            auto result = emit_table_entry(chunk_emitter, ticket_id, *entry);
+            if (result.is_result())
             {
-                character = static_cast<char>(std::toupper(character));
-                character_must_be_uppercase = false;
-            }
-            else
-            {
-                character = static_cast<char>(std::tolower(character));
+                chunk_results[chunk_index] = result.release_result();
+                return;
             }
         }
-        else
-        {
-            character_must_be_uppercase = true;
-            if (last_character == '-')
-                continue;
-        }
+        chunk_emitter << YAML::EndSeq;
+        chunk_emitter << YAML::EndMap;
+
+        if (!StringView(chunk_emitter.c_str(), chunk_emitter.size()).starts_with(entries_key_line))
+            chunk_results[chunk_index] = Result(Result::UnknownError);
+    };
 
-        last_character = character;
-        formatted_name.push_back(character);
+    const auto emit_chunks = [&](usize thread_index)
+    {
+        const usize chunk_begin = (chunk_count * thread_index) / thread_count;
+        const usize chunk_end = (chunk_count * (thread_index + 1)) / thread_count;
+        for (usize chunk_index = chunk_begin; chunk_index < chunk_end; ++chunk_index)
+            emit_chunk(chunk_index);
+    };
+
+    // The calling thread emits the first range of chunks, while the others are emitted by worker threads.
+    Vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (usize thread_index = 1; thread_index < thread_count; ++thread_index)
+        workers.emplace_back(emit_chunks, thread_index);
+    emit_chunks(0);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (const Optional<Result>& chunk_result : chunk_results)
+    {
+        if (chunk_result.has_value())
+            return chunk_result.value();
+    }
+
+    const auto get_chunk_text = [&](usize chunk_index) -> StringView
+    {
+        const YAML::Emitter& chunk_emitter = chunk_emitters[chunk_index];
+        return StringView(chunk_emitter.c_str(), chunk_emitter.size()).substr(entries_key_line.size());
+    };
+
+    // The checksum covers the bytes that follow the line of the 'entries' key, exactly as they are written. A file
+    // whose checksum matches was written by us, so its entries can be loaded without being validated again.
+    u32 entries_crc32c = 0;
+    for (usize chunk_index = 0; chunk_index < chunk_count; ++chunk_index)
+    {
+        if (chunk_index > 0)
+            entries_crc32c = compute_crc32c(StringView("\n"), entries_crc32c);
+        entries_crc32c = compute_crc32c(get_chunk_text(chunk_index), entries_crc32c);
     }
 
-    if ((last_character == '-' || last_character == ' ') && !formatted_name.empty())
-        formatted_name.pop_back();
+    emitter << YAML::Key << "entries_crc32c" << YAML::Value << entries_crc32c;
+    emitter << YAML::EndMap;
+    emitter << YAML::EndMap;
 
-    name = formatted_name;
+    // NOTE: The file is written in binary mode, as the checksum would no longer match if the line endings were
+    //       translated.
+    std::ofstream output(filepath, std::ios::binary);
+    if (!output.is_open())
+        return Result(Result::InvalidFilepath);
+
+    output.write(emitter.c_str(), static_cast<std::streamsize>(emitter.size()));
+    output.put('\n');
+    output.write(entries_key_line.data(), static_cast<std::streamsize>(entries_key_line.size()));
+    for (usize chunk_index = 0; chunk_index < chunk_count; ++chunk_index)
+    {
+        const StringView chunk_text = get_chunk_text(chunk_index);
+        if (chunk_index > 0)
+            output.put('\n');
+        output.write(chunk_text.data(), static_cast<std::streamsize>(chunk_text.size()));
+    }
+
+    if (!output.good())
+        return Result(Result::FileError);
     return {};
 }
 
 ResultOr<void> Table::format_entry(TableEntry& entry)
 {
-    TRY(entry.check_corrupted());
-
-    if (entry.grade < ALLOWED_GRADE_LOW || entry.grade > ALLOWED_GRADE_HIGH)
-        return Result(Result::InvalidEntryField);
-
     entry.grade_id = static_cast<char>(std::toupper(entry.grade_id));
-    if (entry.grade_id < ALLOWED_GRADE_ID_LOW || entry.grade_id > ALLOWED_GRADE_ID_HIGH)
+    if (!is_class_valid(entry.grade, entry.grade_id))
         return Result(Result::InvalidEntryField);
 
     TRY(format_name_string(entry.first_name));
@@ -213,10 +693,36 @@ ResultOr<void> Table::format_entry(TableEntry& entry)
     return {};
 }
 
+ResultOr<void> Table::format_name(String& name)
+{
+    TRY(format_name_string(name));
+    return {};
+}
+
+void Table::set_ticket_code_check_character(Base36CheckCharacter check_character)
+{
+    m_ticket_code_check_character.store(check_character, std::memory_order_relaxed);
+}
+
+String Table::format_ticket_code(TicketID ticket_id) const
+{
+    return transform_to_base_36(ticket_id, ticket_code_check_character());
+}
+
+ResultOr<TicketID> Table::parse_ticket_code(StringView ticket_code) const
+{
+    TRY_ASSIGN(const TicketID ticket_id, transform_from_base_36<u64>(ticket_code, ticket_code_check_character()));
+    return ticket_id;
+}
+
 ResultOr<bool> Table::is_ticket_id_valid(TicketID ticket_id) const
 {
-    auto entry_it = m_entries.find(ticket_id);
-    if (entry_it == m_entries.end())
+    const std::shared_lock lock(m_mutex);
+    if (!might_contain_ticket_id(ticket_id))
+        return false;
+
+    auto entry_it = m_storage->entries.find(ticket_id);
+    if (entry_it == m_storage->entries.end())
         return false;
     return true;
 }
@@ -226,6 +732,7 @@ ResultOr<bool> Table::has_generated_ticket_id_expired(GeneratedTicketID generate
     if (generated_ticket_id.id == invalid_ticket_id)
         return Result(Result::IdInvalid);
 
+    const std::shared_lock lock(m_mutex);
     if (generated_ticket_id.generation == m_ticket_id_generation)
         return false;
 
@@ -239,13 +746,15 @@ ResultOr<Table::GeneratedTicketID> Table::generate_ticket_id()
     // either a digit or a letter from the english alphabet, hence the 36 to the power of 5.
     constexpr u64 ticket_id_high_range = 36ull * 36ull * 36ull * 36ull * 36ull;
 
+    const std::unique_lock lock(m_mutex);
+
     TicketID ticket_id;
     bool ticket_was_generated = false;
 
     for (u32 try_counter = 0; !ticket_was_generated && (try_counter < 512); ++try_counter)
     {
         TRY_ASSIGN(ticket_id, generate_random_unsigned(ticket_id_low_range, ticket_id_high_range));
-        if (m_entries.find(ticket_id) == m_entries.end())
+        if (!might_contain_ticket_id(ticket_id) || m_storage->entries.find(ticket_id) == m_storage->entries.end())
             ticket_was_generated = true;
     }
 
@@ -258,28 +767,23 @@ ResultOr<Table::GeneratedTicketID> Table::generate_ticket_id()
 
 ResultOr<void> Table::insert_entry_with_ticket_id(TicketID ticket_id, TableEntry entry)
 {
-    TRY(entry.check_corrupted());
-
-    if (m_entries.find(ticket_id) != m_entries.end())
-        return Result(Result::IdAlreadyExists);
-
-    TRY_ASSIGN(const bool entry_already_exists, similar_entry_already_exists(entry));
-    if (entry_already_exists)
-        return Result(Result::EntryAlreadyExists);
-
-    TRY(format_entry(entry));
-    TRY(safe_unsigned_increment(m_ticket_id_generation));
-    m_entries.insert({ ticket_id, std::move(entry) });
+    const std::unique_lock lock(m_mutex);
+    TRY(insert_entry_with_ticket_id_unlocked(ticket_id, std::move(entry)));
     return {};
 }
 
 ResultOr<void> Table::insert_entry_with_ticket_id(GeneratedTicketID generated_ticket_id, TableEntry entry)
 {
-    TRY_ASSIGN(const bool has_ticket_id_expired, has_generated_ticket_id_expired(generated_ticket_id));
-    if (has_ticket_id_expired)
+    if (generated_ticket_id.id == invalid_ticket_id)
+        return Result(Result::IdInvalid);
+
+    // NOTE: The generation must be checked while holding the same lock as the insertion. Otherwise, another
+    //       thread could insert an entry between the two, which would make the generated ticket ID expire.
+    const std::unique_lock lock(m_mutex);
+    if (generated_ticket_id.generation != m_ticket_id_generation)
         return Result(Result::IdExpired);
 
-    TRY(insert_entry_with_ticket_id(generated_ticket_id.id, std::move(entry)));
+    TRY(insert_entry_with_ticket_id_unlocked(generated_ticket_id.id, std::move(entry)));
     return {};
 }
 
@@ -290,39 +794,84 @@ ResultOr<TicketID> Table::insert_entry(TableEntry entry)
     return generated_ticket_id.id;
 }
 
+ResultOr<void> Table::insert_entry_with_ticket_id_unlocked(TicketID ticket_id, TableEntry entry)
+{
+    if (m_storage->entries.find(ticket_id) != m_storage->entries.end())
+        return Result(Result::IdAlreadyExists);
+
+    TRY_ASSIGN(const bool entry_already_exists, similar_entry_already_exists(entry));
+    if (entry_already_exists)
+        return Result(Result::EntryAlreadyExists);
+
+    TRY(format_entry(entry));
+    TRY(detach_storage());
+    TRY(safe_unsigned_increment(m_ticket_id_generation));
+    m_statistics.add_entry(entry);
+    m_storage->entries.insert({ ticket_id, std::move(entry) });
+    add_ticket_id_to_filter(ticket_id);
+    return {};
+}
+
 ResultOr<void> Table::remove_ticket(TicketID ticket_id)
 {
-    auto entry_it = m_entries.find(ticket_id);
-    if (entry_it == m_entries.end())
-        return Result(Result::IdNotFound);
+    const std::unique_lock lock(m_mutex);
+
+    TRY_ASSIGN(const TableEntry& entry, get_entry_unlocked(ticket_id));
+    m_statistics.remove_entry(entry);
+
+    TRY(detach_storage());
+    m_storage->entries.erase(ticket_id);
+    return {};
+}
+
+ResultOr<void> Table::change_entry(TicketID ticket_id, TableEntry new_entry)
+{
+    TRY(format_entry(new_entry));
+
+    const std::unique_lock lock(m_mutex);
+    TRY(get_entry_unlocked(ticket_id));
 
-    TRY(entry_it->second.check_corrupted());
-    m_entries.erase(entry_it);
+    TRY(detach_storage());
+    TRY_ASSIGN(TableEntry & entry, get_entry_unlocked(ticket_id));
+
+    // The scans of the entry move to its new class.
+    m_statistics.remove_entry(entry);
+    entry.first_name = std::move(new_entry.first_name);
+    entry.last_name = std::move(new_entry.last_name);
+    entry.grade = new_entry.grade;
+    entry.grade_id = new_entry.grade_id;
+    m_statistics.add_entry(entry);
     return {};
 }
 
 ResultOr<usize> Table::entry_count() const
 {
-    return m_entries.size();
+    const std::shared_lock lock(m_mutex);
+    return m_storage->entries.size();
 }
 
-ResultOr<TableEntry&> Table::get_entry(TicketID ticket_id)
+ResultOr<TableEntry&> Table::get_entry_unlocked(TicketID ticket_id)
 {
-    auto entry_it = m_entries.find(ticket_id);
-    if (entry_it == m_entries.end())
+    if (!might_contain_ticket_id(ticket_id))
+        return Result(Result::IdNotFound);
+
+    auto entry_it = m_storage->entries.find(ticket_id);
+    if (entry_it == m_storage->entries.end())
         return Result(Result::IdNotFound);
 
-    TRY(entry_it->second.check_corrupted());
     return entry_it->second;
 }
 
 ResultOr<const TableEntry&> Table::get_entry(TicketID ticket_id) const
 {
-    auto entry_it = m_entries.find(ticket_id);
-    if (entry_it == m_entries.end())
+    const std::shared_lock lock(m_mutex);
+    if (!might_contain_ticket_id(ticket_id))
+        return Result(Result::IdNotFound);
+
+    auto entry_it = m_storage->entries.find(ticket_id);
+    if (entry_it == m_storage->entries.end())
         return Result(Result::IdNotFound);
 
-    TRY(entry_it->second.check_corrupted());
     return entry_it->second;
 }
 
@@ -342,13 +891,29 @@ ResultOr<Vector<TicketID>> Table::find_ticket_id_by_name(StringView first_name,
     return ticket_ids;
 }
 
-ResultOr<bool> Table::similar_entry_already_exists(const TableEntry& entry) const
+ResultOr<Vector<TableNameMatch>>
+Table::find_similar_names(StringView last_name, StringView first_name, usize max_match_count) const
 {
-    TRY(entry.check_corrupted());
+    // NOTE: The snapshot keeps the entries referenced by the index alive until they are copied into the matches.
+    const TableSnapshot table_snapshot = snapshot();
+    TRY_ASSIGN(const RefPtr<const NameTrigramIndex> name_trigram_index, table_snapshot.get_name_trigram_index());
+
+    Vector<TableNameMatch> matches;
+    for (const NameTrigramMatch& trigram_match : name_trigram_index->search(last_name, first_name, max_match_count))
+    {
+        TableNameMatch& match = matches.emplace_back();
+        match.ticket_id = trigram_match.table_entry->first;
+        match.entry = trigram_match.table_entry->second;
+        match.distance = trigram_match.distance;
+    }
+
+    return matches;
+}
 
-    for (const auto& [ticket_id, existing_entry] : m_entries)
+ResultOr<bool> Table::similar_entry_already_exists(const TableEntry& entry) const
+{
+    for (const auto& [ticket_id, existing_entry] : m_storage->entries)
     {
-        TRY(existing_entry.check_corrupted(Result::CorruptedTable));
         if (existing_entry.grade == entry.grade && existing_entry.grade_id == entry.grade_id &&
             existing_entry.last_name == entry.last_name && existing_entry.first_name == entry.first_name)
             return true;
@@ -357,29 +922,169 @@ ResultOr<bool> Table::similar_entry_already_exists(const TableEntry& entry) cons
     return false;
 }
 
-static ResultOr<void> get_current_date_and_time(TableEntryMetadata& metadata)
+ResultOr<String> format_scan_timestamp(i64 scan_timestamp)
+{
+    String scan_date;
+    TRY(append_scan_timestamp(scan_date, scan_timestamp));
+    return scan_date;
+}
+
+ResultOr<void> append_scan_timestamp(String& output, i64 scan_timestamp)
 {
-    std::time_t t = std::time(0);
+    if (scan_timestamp == invalid_scan_timestamp)
+    {
+        output.append("N/A");
+        return {};
+    }
+
+    const std::time_t t = static_cast<std::time_t>(scan_timestamp);
     std::tm now;
     if (localtime_s(&now, &t) != 0)
         return Result(Result::UnknownFailure);
 
-    metadata.last_scan_date = std::format(
-        "{}/{}/{}-{}:{}:{}", now.tm_mday, now.tm_mon + 1, 1900 + now.tm_year, now.tm_hour, now.tm_min, now.tm_sec
+    std::format_to(
+        std::back_inserter(output),
+        "{}/{}/{}-{}:{}:{}",
+        now.tm_mday,
+        now.tm_mon + 1,
+        1900 + now.tm_year,
+        now.tm_hour,
+        now.tm_min,
+        now.tm_sec
     );
     return {};
 }
 
-ResultOr<void> Table::increment_ticket_scan_count(TicketID ticket_id)
+ResultOr<i64> parse_scan_timestamp(StringView scan_date)
+{
+    if (scan_date == "N/A")
+        return invalid_scan_timestamp;
+
+    // NOTE: The fields are in the same order as they are written by format_scan_timestamp().
+    std::tm date = {};
+    int* const fields[] = { &date.tm_mday, &date.tm_mon, &date.tm_year, &date.tm_hour, &date.tm_min, &date.tm_sec };
+    constexpr char separators[] = { '/', '/', '-', ':', ':', '\0' };
+
+    usize offset = 0;
+    for (usize field_index = 0; field_index < std::size(fields); ++field_index)
+    {
+        int value = 0;
+        usize digit_count = 0;
+        for (; offset < scan_date.size() && scan_date[offset] >= '0' && scan_date[offset] <= '9'; ++offset)
+        {
+            value = value * 10 + (scan_date[offset] - '0');
+            if (++digit_count > 4)
+                return Result(Result::InvalidYAML);
+        }
+
+        if (digit_count == 0)
+            return Result(Result::InvalidYAML);
+        *fields[field_index] = value;
+
+        if (separators[field_index] != '\0')
+        {
+            if (offset >= scan_date.size() || scan_date[offset] != separators[field_index])
+                return Result(Result::InvalidYAML);
+            ++offset;
+        }
+    }
+
+    if (offset != scan_date.size())
+        return Result(Result::InvalidYAML);
+
+    date.tm_mon -= 1;
+    date.tm_year -= 1900;
+    date.tm_isdst = -1;
+
+    const std::time_t scan_timestamp = std::mktime(&date);
+    if (scan_timestamp == static_cast<std::time_t>(-1))
+        return Result(Result::InvalidYAML);
+    return static_cast<i64>(scan_timestamp);
+}
+
+void TableStatistics::add_entry(const TableEntry& entry)
+{
+    const u32 scan_count = entry.metadata.scan_count.load(std::memory_order_relaxed);
+    const u32 scanned_ticket_count = (scan_count > 0) ? 1 : 0;
+
+    TableClassStatistics& class_statistics = get_class(entry.grade, entry.grade_id);
+    class_statistics.ticket_count.fetch_add(1, std::memory_order_relaxed);
+    class_statistics.scanned_ticket_count.fetch_add(scanned_ticket_count, std::memory_order_relaxed);
+    class_statistics.scan_count.fetch_add(scan_count, std::memory_order_relaxed);
+
+    m_ticket_count.fetch_add(1, std::memory_order_relaxed);
+    m_scanned_ticket_count.fetch_add(scanned_ticket_count, std::memory_order_relaxed);
+    m_scan_count.fetch_add(scan_count, std::memory_order_relaxed);
+}
+
+void TableStatistics::remove_entry(const TableEntry& entry)
+{
+    const u32 scan_count = entry.metadata.scan_count.load(std::memory_order_relaxed);
+    const u32 scanned_ticket_count = (scan_count > 0) ? 1 : 0;
+
+    TableClassStatistics& class_statistics = get_class(entry.grade, entry.grade_id);
+    class_statistics.ticket_count.fetch_sub(1, std::memory_order_relaxed);
+    class_statistics.scanned_ticket_count.fetch_sub(scanned_ticket_count, std::memory_order_relaxed);
+    class_statistics.scan_count.fetch_sub(scan_count, std::memory_order_relaxed);
+
+    m_ticket_count.fetch_sub(1, std::memory_order_relaxed);
+    m_scanned_ticket_count.fetch_sub(scanned_ticket_count, std::memory_order_relaxed);
+    m_scan_count.fetch_sub(scan_count, std::memory_order_relaxed);
+}
+
+void TableStatistics::register_scan(const TableEntry& entry, u32 new_scan_count, i64 scan_timestamp)
 {
-    TRY_ASSIGN(auto& entry, get_entry(ticket_id));
+    m_scan_rate.record(scan_timestamp);
+
+    TableClassStatistics& class_statistics = get_class(entry.grade, entry.grade_id);
+    class_statistics.scan_count.fetch_add(1, std::memory_order_relaxed);
+    m_scan_count.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the scan that incremented the counter from zero marks the ticket as scanned, even if the same ticket
+    // is scanned by multiple threads at once.
+    if (new_scan_count == 1)
+    {
+        class_statistics.scanned_ticket_count.fetch_add(1, std::memory_order_relaxed);
+        m_scanned_ticket_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
+static ResultOr<void> register_scan(TableEntry& entry, TableStatistics& statistics)
+{
     if (entry.metadata.flags & TableEntryFlag::NotScannable)
         return Result(Result::IdNotScannable);
 
-    TRY(get_current_date_and_time(entry.metadata));
-    TRY(safe_unsigned_increment(entry.metadata.scan_count));
+    // NOTE: The scan count is incremented with a compare-exchange loop instead of a plain fetch-add,
+    //       in order to keep reporting overflows instead of silently wrapping around.
+    u32 scan_count = entry.metadata.scan_count.load(std::memory_order_relaxed);
+    do
+    {
+        if (scan_count == static_cast<u32>(-1))
+            return Result(Result::IntegerOverflow);
+    } while (!entry.metadata.scan_count.compare_exchange_weak(scan_count, scan_count + 1, std::memory_order_relaxed));
+
+    const i64 scan_timestamp = static_cast<i64>(std::time(nullptr));
+    entry.metadata.last_scan_timestamp.store(scan_timestamp, std::memory_order_relaxed);
+    statistics.register_scan(entry, scan_count + 1, scan_timestamp);
+    return {};
+}
+
+ResultOr<void> Table::increment_ticket_scan_count(TicketID ticket_id)
+{
+    const std::shared_lock lock(m_mutex);
+    TRY_ASSIGN(auto& entry, get_entry_unlocked(ticket_id));
+    TRY(register_scan(entry, m_statistics));
     return {};
 }
 
+ResultOr<TableEntry> Table::scan_ticket(TicketID ticket_id)
+{
+    const std::shared_lock lock(m_mutex);
+    TRY_ASSIGN(auto& entry, get_entry_unlocked(ticket_id));
+    TableEntry entry_before_scan = entry;
+
+    TRY(register_scan(entry, m_statistics));
+    return entry_before_scan;
+}
+
 } // namespace Octopus
@@ -5,12 +5,22 @@
 
 #pragma once
 
+#include "BloomFilter.h"
 #include "Core.h"
+#include "MathUtils.h"
+#include "PoolAllocator.h"
 #include "Result.h"
+#include "ScanRate.h"
 
 namespace Octopus
 {
 
+#define ALLOWED_GRADE_LOW  9
+#define ALLOWED_GRADE_HIGH 12
+
+#define ALLOWED_GRADE_ID_LOW  'A'
+#define ALLOWED_GRADE_ID_HIGH 'F'
+
 using TicketID = u64;
 static constexpr TicketID invalid_ticket_id = 0;
 static constexpr u64 invalid_ticket_generation = 0;
@@ -24,43 +34,248 @@ struct TableEntryFlag
     };
 };
 
+/// Value of TableEntryMetadata::last_scan_timestamp for tickets that were never scanned.
+static constexpr i64 invalid_scan_timestamp = 0;
+
 struct TableEntryMetadata
 {
+public:
+    TableEntryMetadata() = default;
+
+    TableEntryMetadata(const TableEntryMetadata& other)
+        : flags(other.flags)
+        , scan_count(other.scan_count.load(std::memory_order_relaxed))
+        , last_scan_timestamp(other.last_scan_timestamp.load(std::memory_order_relaxed))
+    {
+    }
+
+    TableEntryMetadata& operator=(const TableEntryMetadata& other)
+    {
+        flags = other.flags;
+        scan_count.store(other.scan_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        last_scan_timestamp.store(other.last_scan_timestamp.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+public:
     u32 flags = TableEntryFlag::None;
-    u32 scan_count = 0;
-    String last_scan_date;
-};
 
-/// Packs the 4 given characters into a 32-bit unsigned integer, with the first character
-/// being the most significant byte and the last character the least significant byte.
-#define FOUR_BYTE_HEADER(a, b, c, d) (((a) << 24) | ((b) << 16) | ((c) << 8) | ((d) << 0))
+    // NOTE: The scan counters are atomic, so that scanning a ticket only requires shared access to the table.
+    //       Gate traffic never has to wait for other scans, only for the operations that modify the table layout.
+    std::atomic<u32> scan_count = 0;
+    /// Seconds since the UNIX epoch, or invalid_scan_timestamp if the ticket was never scanned.
+    std::atomic<i64> last_scan_timestamp = invalid_scan_timestamp;
+};
 
-/// Four-byte tag that every table entry must begin with.
-static constexpr u32 table_entry_tag = FOUR_BYTE_HEADER('O', 'P', 'T', 'E');
+/// Formats the scan timestamp as 'day/month/year-hour:minute:second' in the local time zone, which is
+/// also how it is stored in the database file. Tickets that were never scanned are formatted as 'N/A'.
+ResultOr<String> format_scan_timestamp(i64 scan_timestamp);
+/// Same as format_scan_timestamp(), but appends the formatted date to the given string.
+ResultOr<void> append_scan_timestamp(String& output, i64 scan_timestamp);
+ResultOr<i64> parse_scan_timestamp(StringView scan_date);
 
 struct TableEntry
 {
 public:
-    /// If this value is different than table_entry_tag the table entry is corrupted
-    /// and an error must be raised.
-    u32 _entry_tag = table_entry_tag;
     TableEntryMetadata metadata;
 
     String first_name;
     String last_name;
     u8 grade = 0;
     char grade_id = 0;
+};
 
+/// An entry that was read from a database file, but that wasn't inserted in a table yet.
+struct LoadedTableEntry
+{
+    TicketID ticket_id;
+    TableEntry entry;
+};
+
+struct TableClassStatistics
+{
+    std::atomic<u32> ticket_count = 0;
+    /// The number of tickets that were scanned at least once.
+    std::atomic<u32> scanned_ticket_count = 0;
+    std::atomic<u64> scan_count = 0;
+};
+
+///
+/// Aggregated counters of a table, for every class and in total. They are updated by every modification of the
+/// table, so reading them never requires walking the entries. Scans only hold the shared lock of the table, which
+/// is why the counters are atomic.
+///
+class TableStatistics
+{
 public:
-    NODISCARD ALWAYS_INLINE bool is_corrupted() const { return _entry_tag != table_entry_tag; }
-    ALWAYS_INLINE ResultOr<void> check_corrupted(Result::Code result_code = Result::CorruptedTableEntry) const
+    static constexpr usize grade_count = ALLOWED_GRADE_HIGH - ALLOWED_GRADE_LOW + 1;
+    static constexpr usize grade_id_count = ALLOWED_GRADE_ID_HIGH - ALLOWED_GRADE_ID_LOW + 1;
+
+public:
+    /// The entry must be formatted, which guarantees that its class is valid.
+    NODISCARD ALWAYS_INLINE const TableClassStatistics& get_class(u8 grade, char grade_id) const
+    {
+        return m_classes[(grade - ALLOWED_GRADE_LOW) * grade_id_count + (grade_id - ALLOWED_GRADE_ID_LOW)];
+    }
+
+    NODISCARD ALWAYS_INLINE u32 ticket_count() const { return m_ticket_count.load(std::memory_order_relaxed); }
+    NODISCARD ALWAYS_INLINE u32 scanned_ticket_count() const
     {
-        return is_corrupted() ? Result(result_code) : ResultOr<void>();
+        return m_scanned_ticket_count.load(std::memory_order_relaxed);
     }
+    NODISCARD ALWAYS_INLINE u64 scan_count() const { return m_scan_count.load(std::memory_order_relaxed); }
+    NODISCARD ALWAYS_INLINE const ScanRateRecorder& scan_rate() const { return m_scan_rate; }
+
+    void add_entry(const TableEntry& entry);
+    void remove_entry(const TableEntry& entry);
+    /// Must be called after the scan counter of the entry was incremented to the given value.
+    void register_scan(const TableEntry& entry, u32 new_scan_count, i64 scan_timestamp);
+
+private:
+    ALWAYS_INLINE TableClassStatistics& get_class(u8 grade, char grade_id)
+    {
+        return m_classes[(grade - ALLOWED_GRADE_LOW) * grade_id_count + (grade_id - ALLOWED_GRADE_ID_LOW)];
+    }
+
+private:
+    TableClassStatistics m_classes[grade_count * grade_id_count];
+    std::atomic<u32> m_ticket_count = 0;
+    std::atomic<u32> m_scanned_ticket_count = 0;
+    std::atomic<u64> m_scan_count = 0;
+    ScanRateRecorder m_scan_rate;
 };
 
+/// NOTE: The nodes of the map are allocated from a pool, as a large table would otherwise make a separate heap
+///       allocation for every entry. The names don't use an arena: MSVC and libstdc++ store up to 15 characters
+///       inline, and only longer names (usually hyphenated or multi-part ones) make an allocation of their own.
+///       Loading 60k entries, with one in five last names longer than 15 characters, made 12k allocations for the
+///       names kept by the table and 9.8M allocations while parsing the YAML file.
+using TableEntryMap =
+    std::map<TicketID, TableEntry, std::less<TicketID>, PoolAllocator<std::pair<const TicketID, TableEntry>>>;
+
+/// References to the entries of a table, sorted by some criteria.
+using TableEntryIndex = Vector<const TableEntryMap::value_type*>;
+
+class NameTrigramIndex;
+
+/// The entries of a table, which can be shared between the table and its snapshots.
+struct TableStorage
+{
+    TableStorage() = default;
+
+    /// NOTE: Only the entries are copied. The indices of the copy are built again when they are first needed.
+    explicit TableStorage(const TableEntryMap& entries)
+        : entries(entries)
+    {
+    }
+
+    TableEntryMap entries;
+
+    /// The entries sorted by their names, built by the first snapshot that needs it. It is valid as long as the
+    /// entries don't change, which is guaranteed while the storage is shared with a snapshot.
+    mutable std::mutex name_index_mutex;
+    mutable RefPtr<const TableEntryIndex> name_index;
+
+    /// The trigrams of the names, built by the first search for a misspelled name. It is valid under the same
+    /// conditions as the name index.
+    mutable std::mutex name_trigram_index_mutex;
+    mutable RefPtr<const NameTrigramIndex> name_trigram_index;
+};
+
+///
+/// Read-only view of a table, as it was when the snapshot was taken. Snapshots are cheap to take and can be walked
+/// without locking, while the table itself keeps being modified by other threads.
+///
+/// The tickets that exist, their names, classes and flags never change. The scan counters of the entries are at
+/// least as recent as the moment the snapshot was taken, but scans performed later might also be visible.
+///
+class TableSnapshot
+{
+    friend class ShardedTable;
+    friend class Table;
+    friend class TableCursor;
+
+public:
+    NODISCARD ALWAYS_INLINE usize entry_count() const { return m_storage->entries.size(); }
+    ResultOr<const TableEntry&> get_entry(TicketID ticket_id) const;
+
+    template<typename Func>
+    ALWAYS_INLINE ResultOr<void> iterate_over_entries(Func callback) const
+    {
+        for (const auto& [ticket_id, entry] : m_storage->entries)
+        {
+            TRY_ASSIGN(const IterationDecision decision, callback(ticket_id, entry));
+            if (decision == IterationDecision::Break)
+                break;
+        }
+
+        return {};
+    }
+
+    ResultOr<void> save_to_file(const String& filepath) const;
+
+    NODISCARD ALWAYS_INLINE String format_ticket_code(TicketID ticket_id) const
+    {
+        return transform_to_base_36(ticket_id, m_ticket_code_check_character);
+    }
+    NODISCARD ALWAYS_INLINE Base36CheckCharacter ticket_code_check_character() const
+    {
+        return m_ticket_code_check_character;
+    }
+    ResultOr<TicketID> parse_ticket_code(StringView ticket_code) const;
+
+    /// Returns the entries of the snapshot sorted by their last name, first name and ticket ID. The index is built
+    /// only once for every version of the table, and it is kept alive by the snapshot.
+    ResultOr<RefPtr<const TableEntryIndex>> get_name_index() const;
+
+    /// Returns the index used to search for misspelled names. Like the name index, it is built only once for every
+    /// version of the table.
+    ResultOr<RefPtr<const NameTrigramIndex>> get_name_trigram_index() const;
+
+private:
+    explicit TableSnapshot(
+        RefPtr<const TableStorage> storage,
+        Base36CheckCharacter ticket_code_check_character = Base36CheckCharacter::None
+    )
+        : m_storage(std::move(storage))
+        , m_ticket_code_check_character(ticket_code_check_character)
+    {
+    }
+
+private:
+    RefPtr<const TableStorage> m_storage;
+    /// Written to the database file when the snapshot is saved.
+    Base36CheckCharacter m_ticket_code_check_character;
+};
+
+/// An entry whose name is similar to a searched name. The entry is copied, so it stays valid after the table changes.
+struct TableNameMatch
+{
+    TicketID ticket_id;
+    TableEntry entry;
+    /// The edit distance between the searched name and the name of the entry.
+    u32 distance;
+};
+
+/// The number of matches shown when searching for a misspelled name.
+static constexpr usize default_similar_name_match_count = 10;
+
+///
+/// The table can be accessed concurrently from multiple threads. Operations that only read the table, or that
+/// only scan tickets, take a shared lock and never block each other. Operations that insert, remove or change
+/// entries take an exclusive lock.
+///
+/// The references returned by get_entry() stay valid until the table is modified next. However, while holding such
+/// a reference, only the atomic scan counters of the entry can be safely read if other threads modify the table.
+///
+/// Operations that walk the whole table for a long time, such as saving it, should do so through a snapshot. The
+/// entries are copied only when the table is modified while a snapshot of it is still alive.
+///
 class Table
 {
+    friend class ShardedTable;
+    friend class TableSnapshot;
+
 public:
     struct GeneratedTicketID
     {
@@ -80,7 +295,34 @@ public:
     static ResultOr<OwnPtr<Table>> create_from_file(const String& filepath);
     ResultOr<void> save_to_file(const String& filepath) const;
 
+    NODISCARD TableSnapshot snapshot() const;
+
     static ResultOr<void> format_entry(TableEntry& entry);
+    static ResultOr<void> format_name(String& name);
+
+    /// The statistics of the table are indexed by the class, so the class of every entry must be checked before it
+    /// is inserted, even if the rest of the entry is trusted.
+    NODISCARD ALWAYS_INLINE static bool is_class_valid(u32 grade, char grade_id)
+    {
+        return grade >= ALLOWED_GRADE_LOW && grade <= ALLOWED_GRADE_HIGH && grade_id >= ALLOWED_GRADE_ID_LOW &&
+               grade_id <= ALLOWED_GRADE_ID_HIGH;
+    }
+
+    /// Whether the entries of the file the table was loaded from matched the checksum written by save_to_file(), so
+    /// they were inserted without being validated again.
+    NODISCARD ALWAYS_INLINE bool is_loaded_file_verified() const { return m_is_loaded_file_verified; }
+
+    /// The check character of the codes printed on the tickets. It is saved in the info of the database file.
+    NODISCARD ALWAYS_INLINE Base36CheckCharacter ticket_code_check_character() const
+    {
+        return m_ticket_code_check_character.load(std::memory_order_relaxed);
+    }
+    void set_ticket_code_check_character(Base36CheckCharacter check_character);
+
+    /// Returns the code printed on the ticket, which is the ticket ID followed by its check character, if any.
+    NODISCARD String format_ticket_code(TicketID ticket_id) const;
+    /// Codes whose check character doesn't match are rejected with Result::IdInvalid, without accessing the table.
+    ResultOr<TicketID> parse_ticket_code(StringView ticket_code) const;
 
 public:
     ResultOr<bool> is_ticket_id_valid(TicketID ticket_id) const;
@@ -93,31 +335,25 @@ public:
 
     ResultOr<void> remove_ticket(TicketID ticket_id);
 
+    /// Replaces the names and the class of the entry, while keeping its metadata.
+    ResultOr<void> change_entry(TicketID ticket_id, TableEntry new_entry);
+
     ResultOr<usize> entry_count() const;
-    ResultOr<TableEntry&> get_entry(TicketID ticket_id);
     ResultOr<const TableEntry&> get_entry(TicketID ticket_id) const;
     ResultOr<Vector<TicketID>> find_ticket_id_by_name(StringView first_name, StringView last_name) const;
 
-    template<typename Func>
-    ALWAYS_INLINE ResultOr<void> iterate_over_entries(Func callback)
-    {
-        for (auto& [ticket_id, entry] : m_entries)
-        {
-            TRY(entry.check_corrupted(Result::CorruptedTable));
-            TRY_ASSIGN(const IterationDecision decision, callback(ticket_id, entry));
-            if (decision == IterationDecision::Break)
-                break;
-        }
-
-        return {};
-    }
+    /// Returns the entries whose names are the closest to the given, possibly misspelled, name, sorted by their edit
+    /// distance to it. Unlike find_ticket_id_by_name(), the name doesn't have to be formatted.
+    ResultOr<Vector<TableNameMatch>>
+    find_similar_names(StringView last_name, StringView first_name, usize max_match_count) const;
 
+    /// The table is locked for shared access during the iteration, so the callback must not modify the table.
     template<typename Func>
     ALWAYS_INLINE ResultOr<void> iterate_over_entries(Func callback) const
     {
-        for (const auto& [ticket_id, entry] : m_entries)
+        const std::shared_lock lock(m_mutex);
+        for (const auto& [ticket_id, entry] : m_storage->entries)
         {
-            TRY(entry.check_corrupted(Result::CorruptedTable));
             TRY_ASSIGN(const IterationDecision decision, callback(ticket_id, entry));
             if (decision == IterationDecision::Break)
                 break;
@@ -128,12 +364,61 @@ public:
 
     ResultOr<void> increment_ticket_scan_count(TicketID ticket_id);
 
+    /// Registers a scan of the given ticket and returns the entry as it was before the scan.
+    ResultOr<TableEntry> scan_ticket(TicketID ticket_id);
+
+    /// The counters are read without locking the table, so they can be slightly ahead of the entries seen by a
+    /// snapshot that is taken at the same time.
+    NODISCARD ALWAYS_INLINE const TableStatistics& statistics() const { return m_statistics; }
+
 private:
+    struct EntryReference
+    {
+        TicketID ticket_id;
+        const TableEntry* entry;
+    };
+
+    /// Writes the given entries to the database file, in the order they are provided.
+    static ResultOr<void> save_entries_to_file(
+        const String& filepath,
+        Span<const EntryReference> entries,
+        Base36CheckCharacter ticket_code_check_character
+    );
+
     ResultOr<bool> similar_entry_already_exists(const TableEntry& entry) const;
+    /// The entries of a verified file were validated when it was saved, so they are only checked for ID conflicts.
+    ResultOr<void> insert_loaded_entries(Span<Vector<LoadedTableEntry>> chunk_entries, bool entries_are_verified);
+    ResultOr<void> insert_entry_with_ticket_id_unlocked(TicketID ticket_id, TableEntry entry);
+    ResultOr<TableEntry&> get_entry_unlocked(TicketID ticket_id);
+
+    /// Rejects the ticket IDs that are definitely not in the table, without walking the entries.
+    NODISCARD ALWAYS_INLINE bool might_contain_ticket_id(TicketID ticket_id) const
+    {
+        return m_ticket_id_filter.might_contain(ticket_id);
+    }
+
+    /// Must be called after every new entry, while holding the exclusive lock.
+    void add_ticket_id_to_filter(TicketID ticket_id);
+    /// Builds the filter again from the entries of the table, with room for the table to double in size.
+    void rebuild_ticket_id_filter();
+
+    /// Gives the table its own copy of the entries, if they are shared with a snapshot. Must be called while
+    /// holding the exclusive lock, before modifying the entries (other than their scan counters).
+    ResultOr<void> detach_storage();
 
 private:
-    Map<TicketID, TableEntry> m_entries;
+    mutable std::shared_mutex m_mutex;
+    RefPtr<TableStorage> m_storage;
+    TableStatistics m_statistics;
+
+    /// NOTE: Most of the invalid scans are mistyped or forged ticket IDs. The filter rejects them after touching a
+    ///       single cache line, instead of walking the nodes of the map. It belongs to the table rather than to its
+    ///       storage, as snapshots look up single tickets too rarely to need it.
+    BlockedBloomFilter m_ticket_id_filter;
+
+    std::atomic<Base36CheckCharacter> m_ticket_code_check_character = Base36CheckCharacter::None;
     u64 m_ticket_id_generation = invalid_ticket_generation;
+    bool m_is_loaded_file_verified = false;
 };
 
 } // namespace Octopus
@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "TableArchive.h"
+#include "Checksum.h"
+#include "NameFormat.h"
+
+#include <cstring>
+#include <thread>
+
+namespace Octopus
+{
+
+// NOTE: The integers of the header and of the block index are stored in little-endian order, which is what every
+//       supported platform uses, so they are copied to and from the file as they are.
+static constexpr StringView archive_signature = "OCTA";
+static constexpr u16 archive_version = 1;
+static constexpr usize archive_header_size = 36;
+static constexpr usize archive_block_info_size = 40;
+
+/// Blocks of this many entries take a few tens of kilobytes, which is small enough to read a single entry quickly and
+/// large enough for the names to repeat within a block.
+static constexpr usize archive_block_entry_count = 1024;
+/// Entries take a few tens of bytes, so this is far beyond any block of real names. The bound exists so that the index
+/// of a corrupted archive can't make a block allocate gigabytes before it is decompressed; saving larger blocks fails.
+static constexpr usize max_archive_entry_size = 1024;
+static constexpr usize max_archive_block_size = archive_block_entry_count * max_archive_entry_size;
+/// Encoding fewer blocks than this isn't worth the cost of starting a thread.
+static constexpr usize min_archive_blocks_per_thread = 16;
+
+template<typename T>
+ALWAYS_INLINE static void append_integer(String& out, T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+/// Variable-length integer, with 7 bits in every byte and the highest bit set on all the bytes except the last one.
+static void append_varint(String& out, u64 value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/// Reads the values written by the functions above, failing instead of reading past the end of the data.
+class ArchiveDataReader
+{
+public:
+    explicit ArchiveDataReader(StringView data)
+        : m_data(data)
+    {
+    }
+
+    template<typename T>
+    ResultOr<T> read_integer()
+    {
+        if (m_data.size() - m_offset < sizeof(T))
+            return Result(Result::CorruptedTable);
+
+        T value;
+        std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    ResultOr<u64> read_varint()
+    {
+        u64 value = 0;
+        for (u32 shift = 0; shift < 64; shift += 7)
+        {
+            if (m_offset == m_data.size())
+                return Result(Result::CorruptedTable);
+
+            const u8 byte = static_cast<u8>(m_data[m_offset++]);
+            value |= static_cast<u64>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        return Result(Result::CorruptedTable);
+    }
+
+    ResultOr<String> read_string()
+    {
+        TRY_ASSIGN(const u64 size, read_varint());
+        if (size > m_data.size() - m_offset)
+            return Result(Result::CorruptedTable);
+
+        String value(m_data.substr(m_offset, size));
+        m_offset += size;
+        return value;
+    }
+
+    NODISCARD ALWAYS_INLINE bool has_reached_end() const { return m_offset == m_data.size(); }
+
+private:
+    StringView m_data;
+    usize m_offset = 0;
+};
+
+/// Maps small negative numbers to small unsigned numbers, so they are encoded in few bytes.
+NODISCARD ALWAYS_INLINE static u64 encode_zigzag(i64 value)
+{
+    return (static_cast<u64>(value) << 1) ^ static_cast<u64>(value >> 63);
+}
+
+NODISCARD ALWAYS_INLINE static i64 decode_zigzag(u64 value)
+{
+    return static_cast<i64>(value >> 1) ^ -static_cast<i64>(value & 1);
+}
+
+/// The ticket IDs are sorted, so they are stored as the difference from the previous ticket ID of the block.
+static void encode_entry(String& out, TicketID previous_ticket_id, TicketID ticket_id, const TableEntry& entry)
+{
+    append_varint(out, ticket_id - previous_ticket_id);
+    out.push_back(static_cast<char>(entry.grade));
+    out.push_back(entry.grade_id);
+    append_varint(out, entry.metadata.flags);
+    append_varint(out, entry.metadata.scan_count.load(std::memory_order_relaxed));
+    append_varint(out, encode_zigzag(entry.metadata.last_scan_timestamp.load(std::memory_order_relaxed)));
+    append_varint(out, entry.first_name.size());
+    out.append(entry.first_name);
+    append_varint(out, entry.last_name.size());
+    out.append(entry.last_name);
+}
+
+static ResultOr<void> decode_entry(ArchiveDataReader& reader, TicketID previous_ticket_id, LoadedTableEntry& out_entry)
+{
+    TRY_ASSIGN(const u64 ticket_id_delta, reader.read_varint());
+    if (ticket_id_delta == 0 || ticket_id_delta > UINT64_MAX - previous_ticket_id)
+        return Result(Result::CorruptedTable);
+    out_entry.ticket_id = previous_ticket_id + ticket_id_delta;
+
+    // NOTE: The entries of an archive are inserted without being formatted, as they were formatted before they were
+    //       saved. The checksum of the block doesn't prove that, so the fields that the table relies on are checked:
+    //       the class indexes the statistics of the table, and the names are exported without being escaped.
+    TableEntry& entry = out_entry.entry;
+    TRY_ASSIGN(entry.grade, reader.read_integer<u8>());
+    TRY_ASSIGN(entry.grade_id, reader.read_integer<char>());
+    if (!Table::is_class_valid(entry.grade, entry.grade_id))
+        return Result(Result::CorruptedTableEntry);
+
+    TRY_ASSIGN(const u64 flags, reader.read_varint());
+    TRY_ASSIGN(const u64 scan_count, reader.read_varint());
+    TRY_ASSIGN(const u64 last_scan_timestamp, reader.read_varint());
+    if (flags > UINT32_MAX || scan_count > UINT32_MAX)
+        return Result(Result::CorruptedTable);
+    entry.metadata.flags = static_cast<u32>(flags);
+    entry.metadata.scan_count = static_cast<u32>(scan_count);
+    entry.metadata.last_scan_timestamp = decode_zigzag(last_scan_timestamp);
+
+    TRY_ASSIGN(entry.first_name, reader.read_string());
+    TRY_ASSIGN(entry.last_name, reader.read_string());
+    if (!are_name_characters_valid(entry.first_name) || !are_name_characters_valid(entry.last_name))
+        return Result(Result::CorruptedTableEntry);
+    return {};
+}
+
+ResultOr<void>
+TableArchive::save(const String& filepath, const TableSnapshot& table_snapshot, BlockCompression compression)
+{
+    Vector<std::pair<TicketID, const TableEntry*>> entries;
+    entries.reserve(table_snapshot.entry_count());
+    TRY(table_snapshot.iterate_over_entries(
+        [&](TicketID ticket_id, const TableEntry& entry) -> ResultOr<IterationDecision>
+        {
+            entries.emplace_back(ticket_id, &entry);
+            return IterationDecision::Continue;
+        }
+    ));
+
+    const usize block_count = (entries.size() + archive_block_entry_count - 1) / archive_block_entry_count;
+    if (block_count > UINT32_MAX)
+        return Result(Result::IntegerOverflow);
+
+    Vector<String> compressed_blocks(block_count);
+    Vector<BlockInfo> blocks(block_count);
+
+    const usize hardware_thread_count = std::max<usize>(std::thread::hardware_concurrency(), 1);
+    const usize thread_count =
+        std::clamp<usize>(block_count / min_archive_blocks_per_thread, 1, hardware_thread_count);
+
+    Vector<Optional<Result>> thread_results(thread_count);
+    const auto encode_blocks = [&](usize thread_index)
+    {
+        const usize block_begin = (block_count * thread_index) / thread_count;
+        const usize block_end = (block_count * (thread_index + 1)) / thread_count;
+
+        String block_data;
+        for (usize block_index = block_begin; block_index < block_end; ++block_index)
+        {
+            const usize entry_begin = block_index * archive_block_entry_count;
+            const usize entry_end = std::min(entry_begin + archive_block_entry_count, entries.size());
+
+            block_data.clear();
+            TicketID previous_ticket_id = invalid_ticket_id;
+            for (usize entry_index = entry_begin; entry_index < entry_end; ++entry_index)
+            {
+                const auto& [ticket_id, entry] = entries[entry_index];
+                encode_entry(block_data, previous_ticket_id, ticket_id, *entry);
+                previous_ticket_id = ticket_id;
+            }
+
+            String& compressed_block = compressed_blocks[block_index];
+            compress_block(compression, block_data, compressed_block);
+            if (block_data.size() > max_archive_block_size || compressed_block.size() > UINT32_MAX)
+            {
+                thread_results[thread_index] = Result(Result::IntegerOverflow);
+                return;
+            }
+
+            BlockInfo& block = blocks[block_index];
+            block.compressed_size = static_cast<u32>(compressed_block.size());
+            block.size = static_cast<u32>(block_data.size());
+            block.entry_count = static_cast<u32>(entry_end - entry_begin);
+            block.crc32c = compute_crc32c(compressed_block);
+            block.first_ticket_id = entries[entry_begin].first;
+            block.last_ticket_id = entries[entry_end - 1].first;
+        }
+    };
+
+    // The calling thread encodes the first range of blocks, while the others are encoded by worker threads.
+    Vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (usize thread_index = 1; thread_index < thread_count; ++thread_index)
+        workers.emplace_back(encode_blocks, thread_index);
+    encode_blocks(0);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (const Optional<Result>& thread_result : thread_results)
+    {
+        if (thread_result.has_value())
+            return thread_result.value();
+    }
+
+    // The blocks are written right after the header, and the index right after the blocks.
+    u64 block_offset = archive_header_size;
+    String index_data;
+    index_data.reserve(block_count * archive_block_info_size);
+    for (BlockInfo& block : blocks)
+    {
+        block.offset = block_offset;
+        block_offset += block.compressed_size;
+
+        append_integer(index_data, block.offset);
+        append_integer(index_data, block.compressed_size);
+        append_integer(index_data, block.size);
+        append_integer(index_data, block.entry_count);
+        append_integer(index_data, block.crc32c);
+        append_integer(index_data, block.first_ticket_id);
+        append_integer(index_data, block.last_ticket_id);
+    }
+
+    String header_data;
+    header_data.reserve(archive_header_size);
+    header_data.append(archive_signature);
+    append_integer(header_data, archive_version);
+    append_integer(header_data, static_cast<u8>(compression));
+    append_integer(header_data, static_cast<u8>(table_snapshot.ticket_code_check_character()));
+    append_integer(header_data, static_cast<u32>(block_count));
+    append_integer(header_data, static_cast<u64>(entries.size()));
+    append_integer(header_data, block_offset);
+    append_integer(header_data, compute_crc32c(index_data));
+    append_integer(header_data, compute_crc32c(header_data));
+
+    std::ofstream output(filepath, std::ios::binary);
+    if (!output.is_open())
+        return Result(Result::InvalidFilepath);
+
+    output.write(header_data.data(), static_cast<std::streamsize>(header_data.size()));
+    for (const String& compressed_block : compressed_blocks)
+        output.write(compressed_block.data(), static_cast<std::streamsize>(compressed_block.size()));
+    output.write(index_data.data(), static_cast<std::streamsize>(index_data.size()));
+
+    if (!output.good())
+        return Result(Result::FileError);
+    return {};
+}
+
+bool TableArchive::has_archive_signature(StringView file_data)
+{
+    return file_data.starts_with(archive_signature);
+}
+
+ResultOr<TableArchive::Header> TableArchive::parse_header(StringView header_data)
+{
+    if (header_data.size() < archive_header_size || !has_archive_signature(header_data))
+        return Result(Result::CorruptedTable);
+
+    // The last field is the checksum of all the other fields of the header.
+    const StringView checked_header_data = header_data.substr(0, archive_header_size - sizeof(u32));
+    ArchiveDataReader reader(
+        header_data.substr(archive_signature.size(), archive_header_size - archive_signature.size())
+    );
+
+    TRY_ASSIGN(const u16 version, reader.read_integer<u16>());
+    TRY_ASSIGN(const u8 compression, reader.read_integer<u8>());
+    TRY_ASSIGN(const u8 ticket_code_check_character, reader.read_integer<u8>());
+
+    Header header;
+    TRY_ASSIGN(header.block_count, reader.read_integer<u32>());
+    TRY_ASSIGN(header.entry_count, reader.read_integer<u64>());
+    TRY_ASSIGN(header.index_offset, reader.read_integer<u64>());
+    TRY_ASSIGN(header.index_crc32c, reader.read_integer<u32>());
+    TRY_ASSIGN(const u32 header_crc32c, reader.read_integer<u32>());
+
+    if (header_crc32c != compute_crc32c(checked_header_data))
+        return Result(Result::CorruptedTable);
+    if (version != archive_version)
+        return Result(Result::CorruptedTable);
+    if (compression > static_cast<u8>(BlockCompression::LZ4))
+        return Result(Result::CorruptedTable);
+    if (ticket_code_check_character > static_cast<u8>(Base36CheckCharacter::LuhnMod36))
+        return Result(Result::CorruptedTable);
+
+    header.compression = static_cast<BlockCompression>(compression);
+    header.ticket_code_check_character = static_cast<Base36CheckCharacter>(ticket_code_check_character);
+    return header;
+}
+
+ResultOr<void>
+TableArchive::parse_block_index(const Header& header, StringView index_data, Vector<BlockInfo>& out_blocks)
+{
+    if (index_data.size() != static_cast<usize>(header.block_count) * archive_block_info_size)
+        return Result(Result::CorruptedTable);
+    if (compute_crc32c(index_data) != header.index_crc32c)
+        return Result(Result::CorruptedTable);
+
+    ArchiveDataReader reader(index_data);
+    out_blocks.resize(header.block_count);
+    u64 entry_count = 0;
+    for (usize block_index = 0; block_index < out_blocks.size(); ++block_index)
+    {
+        BlockInfo& block = out_blocks[block_index];
+        TRY_ASSIGN(block.offset, reader.read_integer<u64>());
+        TRY_ASSIGN(block.compressed_size, reader.read_integer<u32>());
+        TRY_ASSIGN(block.size, reader.read_integer<u32>());
+        TRY_ASSIGN(block.entry_count, reader.read_integer<u32>());
+        TRY_ASSIGN(block.crc32c, reader.read_integer<u32>());
+        TRY_ASSIGN(block.first_ticket_id, reader.read_integer<u64>());
+        TRY_ASSIGN(block.last_ticket_id, reader.read_integer<u64>());
+
+        // The blocks must lie between the header and the index, and their ranges of ticket IDs must be sorted, so
+        // the index can be binary searched.
+        if (block.offset < archive_header_size || block.offset > header.index_offset ||
+            block.compressed_size > header.index_offset - block.offset)
+            return Result(Result::CorruptedTable);
+        if (block.entry_count == 0 || block.entry_count > archive_block_entry_count ||
+            block.size > max_archive_block_size || block.first_ticket_id == invalid_ticket_id ||
+            block.first_ticket_id > block.last_ticket_id)
+            return Result(Result::CorruptedTable);
+        if (block_index > 0 && out_blocks[block_index - 1].last_ticket_id >= block.first_ticket_id)
+            return Result(Result::CorruptedTable);
+
+        entry_count += block.entry_count;
+    }
+
+    if (entry_count != header.entry_count)
+        return Result(Result::CorruptedTable);
+    return {};
+}
+
+ResultOr<void> TableArchive::decode_block(
+    const Header& header,
+    const BlockInfo& block,
+    StringView compressed_block,
+    Vector<LoadedTableEntry>& out_entries
+)
+{
+    if (compute_crc32c(compressed_block) != block.crc32c)
+        return Result(Result::CorruptedTable);
+
+    String block_data(block.size, '\0');
+    TRY(decompress_block(header.compression, compressed_block, Span<char>(block_data.data(), block_data.size())));
+
+    ArchiveDataReader reader(block_data);
+    TicketID previous_ticket_id = invalid_ticket_id;
+    for (u32 entry_index = 0; entry_index < block.entry_count; ++entry_index)
+    {
+        LoadedTableEntry& loaded_entry = out_entries.emplace_back();
+        TRY(decode_entry(reader, previous_ticket_id, loaded_entry));
+        if (entry_index == 0 && loaded_entry.ticket_id != block.first_ticket_id)
+            return Result(Result::CorruptedTable);
+        previous_ticket_id = loaded_entry.ticket_id;
+    }
+
+    if (!reader.has_reached_end() || previous_ticket_id != block.last_ticket_id)
+        return Result(Result::CorruptedTable);
+    return {};
+}
+
+ResultOr<void> TableArchive::load_entries(
+    StringView file_data,
+    Vector<Vector<LoadedTableEntry>>& out_chunk_entries,
+    Base36CheckCharacter& out_ticket_code_check_character
+)
+{
+    TRY_ASSIGN(const Header header, parse_header(file_data));
+    if (header.index_offset > file_data.size())
+        return Result(Result::CorruptedTable);
+
+    Vector<BlockInfo> blocks;
+    TRY(parse_block_index(header, file_data.substr(header.index_offset), blocks));
+
+    const usize hardware_thread_count = std::max<usize>(std::thread::hardware_concurrency(), 1);
+    const usize chunk_count =
+        std::clamp<usize>(blocks.size() / min_archive_blocks_per_thread, 1, hardware_thread_count);
+    out_chunk_entries.resize(chunk_count);
+
+    Vector<Optional<Result>> chunk_results(chunk_count);
+    const auto load_chunk = [&](usize chunk_index)
+    {
+        const usize block_begin = (blocks.size() * chunk_index) / chunk_count;
+        const usize block_end = (blocks.size() * (chunk_index + 1)) / chunk_count;
+
+        Vector<LoadedTableEntry>& chunk_entries = out_chunk_entries[chunk_index];
+        chunk_entries.reserve(static_cast<usize>(block_end - block_begin) * archive_block_entry_count);
+        for (usize block_index = block_begin; block_index < block_end; ++block_index)
+        {
+            const BlockInfo& block = blocks[block_index];
+            auto result =
+                decode_block(header, block, file_data.substr(block.offset, block.compressed_size), chunk_entries);
+            if (result.is_result())
+            {
+                chunk_results[chunk_index] = result.release_result();
+                return;
+            }
+        }
+    };
+
+    // The calling thread loads the first chunk, while the others are loaded by worker threads.
+    Vector<std::thread> workers;
+    workers.reserve(chunk_count - 1);
+    for (usize chunk_index = 1; chunk_index < chunk_count; ++chunk_index)
+        workers.emplace_back(load_chunk, chunk_index);
+    load_chunk(0);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (const Optional<Result>& chunk_result : chunk_results)
+    {
+        if (chunk_result.has_value())
+            return chunk_result.value();
+    }
+
+    out_ticket_code_check_character = header.ticket_code_check_character;
+    return {};
+}
+
+ResultOr<OwnPtr<TableArchive>> TableArchive::open(const String& filepath)
+{
+    OwnPtr<TableArchive> archive = OwnPtr<TableArchive>(new TableArchive());
+    if (!archive)
+        return Result(Result::OutOfMemory);
+
+    std::ifstream& file = archive->m_file;
+    file.open(filepath, std::ios::binary);
+    if (!file.is_open())
+        return Result(Result::InvalidFilepath);
+
+    String header_data(archive_header_size, '\0');
+    file.read(header_data.data(), static_cast<std::streamsize>(header_data.size()));
+    if (static_cast<usize>(file.gcount()) != header_data.size())
+        return Result(Result::CorruptedTable);
+    TRY_ASSIGN(archive->m_header, parse_header(header_data));
+
+    String index_data(static_cast<usize>(archive->m_header.block_count) * archive_block_info_size, '\0');
+    file.seekg(static_cast<std::streamoff>(archive->m_header.index_offset));
+    file.read(index_data.data(), static_cast<std::streamsize>(index_data.size()));
+    if (static_cast<usize>(file.gcount()) != index_data.size())
+        return Result(Result::CorruptedTable);
+    TRY(parse_block_index(archive->m_header, index_data, archive->m_blocks));
+
+    return archive;
+}
+
+ResultOr<TableEntry> TableArchive::find_entry(TicketID ticket_id)
+{
+    const auto block_it = std::lower_bound(
+        m_blocks.begin(),
+        m_blocks.end(),
+        ticket_id,
+        [](const BlockInfo& block, TicketID value) { return block.last_ticket_id < value; }
+    );
+    if (block_it == m_blocks.end() || block_it->first_ticket_id > ticket_id)
+        return Result(Result::IdNotFound);
+
+    String compressed_block(block_it->compressed_size, '\0');
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(block_it->offset));
+    m_file.read(compressed_block.data(), static_cast<std::streamsize>(compressed_block.size()));
+    if (static_cast<usize>(m_file.gcount()) != compressed_block.size())
+        return Result(Result::FileError);
+
+    Vector<LoadedTableEntry> entries;
+    entries.reserve(block_it->entry_count);
+    TRY(decode_block(m_header, *block_it, compressed_block, entries));
+
+    const auto entry_it = std::lower_bound(
+        entries.begin(),
+        entries.end(),
+        ticket_id,
+        [](const LoadedTableEntry& entry, TicketID value) { return entry.ticket_id < value; }
+    );
+    if (entry_it == entries.end() || entry_it->ticket_id != ticket_id)
+        return Result(Result::IdNotFound);
+    return std::move(entry_it->entry);
+}
+
+} // namespace Octopus
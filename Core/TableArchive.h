@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "BlockCompression.h"
+#include "Core.h"
+#include "Result.h"
+#include "Table.h"
+
+#include <fstream>
+
+namespace Octopus
+{
+
+///
+/// Compact binary copy of a table, used to archive the databases of past events. The entries are sorted by their
+/// ticket ID and split into blocks, and every block is compressed on its own and protected by a CRC-32C. The block
+/// index at the end of the file holds the range of ticket IDs of every block, so a single entry can be read without
+/// decompressing the rest of the archive.
+///
+/// Archives are recognized by Table::create_from_file(), so they can be opened like any other database file.
+///
+class TableArchive
+{
+public:
+    OCT_NONCOPYABLE(TableArchive)
+    OCT_NONMOVABLE(TableArchive)
+    ~TableArchive() = default;
+
+public:
+    /// Writes the entries of the snapshot to an archive. The blocks are encoded and compressed in parallel.
+    static ResultOr<void>
+    save(const String& filepath, const TableSnapshot& table_snapshot, BlockCompression compression);
+
+    /// Returns whether the contents of a file begin with the signature of an archive.
+    NODISCARD static bool has_archive_signature(StringView file_data);
+
+    /// Decodes all the entries of an archive that was read into memory. The blocks are verified and decompressed
+    /// in parallel, and every chunk of the output holds the entries of consecutive blocks, in order.
+    static ResultOr<void> load_entries(
+        StringView file_data,
+        Vector<Vector<LoadedTableEntry>>& out_chunk_entries,
+        Base36CheckCharacter& out_ticket_code_check_character
+    );
+
+    /// Reads only the header and the block index of the archive. The entries are read when they are looked up.
+    static ResultOr<OwnPtr<TableArchive>> open(const String& filepath);
+
+    /// Reads and decompresses only the block whose range of ticket IDs contains the given ticket ID.
+    ResultOr<TableEntry> find_entry(TicketID ticket_id);
+
+    NODISCARD ALWAYS_INLINE u64 entry_count() const { return m_header.entry_count; }
+    NODISCARD ALWAYS_INLINE usize block_count() const { return m_blocks.size(); }
+    NODISCARD ALWAYS_INLINE BlockCompression compression() const { return m_header.compression; }
+    NODISCARD ALWAYS_INLINE Base36CheckCharacter ticket_code_check_character() const
+    {
+        return m_header.ticket_code_check_character;
+    }
+
+private:
+    struct Header
+    {
+        BlockCompression compression = BlockCompression::None;
+        Base36CheckCharacter ticket_code_check_character = Base36CheckCharacter::None;
+        u32 block_count = 0;
+        u64 entry_count = 0;
+        u64 index_offset = 0;
+        u32 index_crc32c = 0;
+    };
+
+    struct BlockInfo
+    {
+        u64 offset = 0;
+        u32 compressed_size = 0;
+        u32 size = 0;
+        u32 entry_count = 0;
+        /// The checksum of the compressed block, as it is stored in the file.
+        u32 crc32c = 0;
+        TicketID first_ticket_id = invalid_ticket_id;
+        TicketID last_ticket_id = invalid_ticket_id;
+    };
+
+private:
+    TableArchive() = default;
+
+    static ResultOr<Header> parse_header(StringView header_data);
+    static ResultOr<void> parse_block_index(const Header& header, StringView index_data, Vector<BlockInfo>& out_blocks);
+    static ResultOr<void> decode_block(
+        const Header& header,
+        const BlockInfo& block,
+        StringView compressed_block,
+        Vector<LoadedTableEntry>& out_entries
+    );
+
+private:
+    Header m_header;
+    Vector<BlockInfo> m_blocks;
+    std::ifstream m_file;
+};
+
+} // namespace Octopus
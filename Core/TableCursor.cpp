@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "TableCursor.h"
+
+namespace Octopus
+{
+
+ResultOr<OwnPtr<TableCursor>> TableCursor::create(TableSnapshot table_snapshot, TableCursorOrder order)
+{
+    OwnPtr<TableCursor> cursor = OwnPtr<TableCursor>(new TableCursor(std::move(table_snapshot), order));
+    if (!cursor)
+        return Result(Result::OutOfMemory);
+
+    const TableEntryMap& entries = cursor->m_table_snapshot.m_storage->entries;
+    switch (order)
+    {
+        case TableCursorOrder::TicketID:
+        {
+            cursor->m_entry_iterator = entries.begin();
+            break;
+        }
+
+        case TableCursorOrder::Name:
+        {
+            TRY_ASSIGN(cursor->m_index, cursor->m_table_snapshot.get_name_index());
+            break;
+        }
+
+        case TableCursorOrder::ScanCount:
+        {
+            struct ScanCountKey
+            {
+                u32 scan_count;
+                const TableEntryMap::value_type* table_entry;
+            };
+
+            // NOTE: The counters are read only once, so the order stays consistent while it is being sorted.
+            Vector<ScanCountKey> keys;
+            keys.reserve(entries.size());
+            for (const auto& table_entry : entries)
+            {
+                const u32 scan_count = table_entry.second.metadata.scan_count.load(std::memory_order_relaxed);
+                keys.push_back({ scan_count, &table_entry });
+            }
+
+            // The entries are already sorted by their ticket ID, which is kept for equal scan counts.
+            std::stable_sort(
+                keys.begin(),
+                keys.end(),
+                [](const ScanCountKey& a, const ScanCountKey& b) { return a.scan_count > b.scan_count; }
+            );
+
+            RefPtr<TableEntryIndex> index = std::make_shared<TableEntryIndex>();
+            if (!index)
+                return Result(Result::OutOfMemory);
+            index->reserve(keys.size());
+            for (const ScanCountKey& key : keys)
+                index->push_back(key.table_entry);
+
+            cursor->m_index = std::move(index);
+            break;
+        }
+    }
+
+    return cursor;
+}
+
+ResultOr<TableCursorOrder> TableCursor::parse_order(StringView order_name)
+{
+    if (order_name == "id")
+        return TableCursorOrder::TicketID;
+    if (order_name == "name")
+        return TableCursorOrder::Name;
+    if (order_name == "scans")
+        return TableCursorOrder::ScanCount;
+    return Result(Result::InvalidParameter);
+}
+
+} // namespace Octopus
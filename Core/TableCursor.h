@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Table.h"
+
+namespace Octopus
+{
+
+enum class TableCursorOrder : u8
+{
+    /// Ascending ticket IDs, which is the order the entries are stored in.
+    TicketID,
+    /// Ascending last names, then first names.
+    Name,
+    /// Descending scan counts, so the most scanned tickets come first.
+    ScanCount,
+};
+
+///
+/// Walks a snapshot of the table one page at a time, in the given order. The cursor remembers its position, so the
+/// next page can be requested at any time later and it describes the same version of the table as the first one.
+///
+/// The cost of a page doesn't depend on the size of the table: the ticket ID order walks the entries directly and
+/// the name order uses the index cached by the snapshot, which is built only once for every version of the table.
+/// The scan count order can't be cached, as the counters keep changing, so it is sorted when the cursor is created.
+///
+class TableCursor
+{
+public:
+    OCT_NONCOPYABLE(TableCursor)
+    OCT_NONMOVABLE(TableCursor)
+    ~TableCursor() = default;
+
+public:
+    static ResultOr<OwnPtr<TableCursor>> create(TableSnapshot table_snapshot, TableCursorOrder order);
+
+    /// Accepts 'id', 'name' and 'scans'.
+    static ResultOr<TableCursorOrder> parse_order(StringView order_name);
+
+    /// Invokes the callback for at most the given number of entries, starting from the current position, and
+    /// advances the cursor past them.
+    template<typename Func>
+    ResultOr<void> next_page(usize page_size, Func callback)
+    {
+        for (usize index = 0; index < page_size && !has_reached_end(); ++index)
+        {
+            const TableEntryMap::value_type* table_entry;
+            if (m_order == TableCursorOrder::TicketID)
+                table_entry = &*m_entry_iterator++;
+            else
+                table_entry = (*m_index)[m_position];
+            ++m_position;
+
+            TRY(callback(table_entry->first, table_entry->second));
+        }
+
+        return {};
+    }
+
+    NODISCARD ALWAYS_INLINE bool has_reached_end() const { return m_position == m_table_snapshot.entry_count(); }
+
+    /// The number of entries that were already walked.
+    NODISCARD ALWAYS_INLINE usize position() const { return m_position; }
+    NODISCARD ALWAYS_INLINE usize entry_count() const { return m_table_snapshot.entry_count(); }
+
+private:
+    TableCursor(TableSnapshot table_snapshot, TableCursorOrder order)
+        : m_table_snapshot(std::move(table_snapshot))
+        , m_order(order)
+    {
+    }
+
+private:
+    TableSnapshot m_table_snapshot;
+    TableCursorOrder m_order;
+    usize m_position = 0;
+
+    /// Only used by the ticket ID order.
+    TableEntryMap::const_iterator m_entry_iterator;
+
+    /// Only used by the name and scan count orders.
+    RefPtr<const TableEntryIndex> m_index;
+};
+
+} // namespace Octopus
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "TableExport.h"
+#include "MathUtils.h"
+
+#include <format>
+
+namespace Octopus
+{
+
+static constexpr usize export_buffer_capacity = 1024 * 1024;
+/// The buffer is written to the file once it grows past this size, which leaves enough room for the next entry.
+static constexpr usize export_buffer_flush_threshold = export_buffer_capacity - 4 * 1024;
+
+ResultOr<OwnPtr<TableExporter>> TableExporter::create(const String& filepath, TableExportFormat format)
+{
+    OwnPtr<TableExporter> exporter = OwnPtr<TableExporter>(new TableExporter(format));
+    if (!exporter)
+        return Result(Result::OutOfMemory);
+
+    exporter->m_output.open(filepath, std::ios::binary);
+    if (!exporter->m_output.is_open())
+        return Result(Result::InvalidFilepath);
+
+    exporter->m_buffer.reserve(export_buffer_capacity);
+    if (format == TableExportFormat::CSV)
+        exporter->m_buffer.append("ticket_id,first_name,last_name,grade,grade_id,flags,scan_count,last_scan_date\n");
+
+    return exporter;
+}
+
+ResultOr<TableExportFormat> TableExporter::parse_format(StringView format_name)
+{
+    if (format_name == "csv")
+        return TableExportFormat::CSV;
+    if (format_name == "jsonl")
+        return TableExportFormat::JSONLines;
+    return Result(Result::InvalidParameter);
+}
+
+ResultOr<void>
+TableExporter::write_entry(const TableSnapshot& table_snapshot, TicketID ticket_id, const TableEntry& entry)
+{
+    // NOTE: The names only contain letters, spaces and dashes (see Table::format_entry() and the checks of the
+    //       loaders), so they never have to be quoted or escaped. The ticket ID is short enough to not allocate memory.
+    const String ticket_id_string = table_snapshot.format_ticket_code(ticket_id);
+    auto output = std::back_inserter(m_buffer);
+
+    if (m_format == TableExportFormat::CSV)
+    {
+        std::format_to(
+            output,
+            "{},{},{},{},{},{},{},",
+            ticket_id_string,
+            entry.first_name,
+            entry.last_name,
+            static_cast<u32>(entry.grade),
+            entry.grade_id,
+            entry.metadata.flags,
+            entry.metadata.scan_count.load()
+        );
+        TRY(append_scan_timestamp(m_buffer, entry.metadata.last_scan_timestamp));
+        m_buffer.push_back('\n');
+    }
+    else
+    {
+        std::format_to(
+            output,
+            R"({{"ticket_id":"{}","first_name":"{}","last_name":"{}","grade":{},"grade_id":"{}","flags":{},)"
+            R"("scan_count":{},"last_scan_date":")",
+            ticket_id_string,
+            entry.first_name,
+            entry.last_name,
+            static_cast<u32>(entry.grade),
+            entry.grade_id,
+            entry.metadata.flags,
+            entry.metadata.scan_count.load()
+        );
+        TRY(append_scan_timestamp(m_buffer, entry.metadata.last_scan_timestamp));
+        m_buffer.append("\"}\n");
+    }
+
+    ++m_exported_entry_count;
+    if (m_buffer.size() >= export_buffer_flush_threshold)
+        TRY(flush());
+    return {};
+}
+
+ResultOr<void> TableExporter::finish()
+{
+    TRY(flush());
+    m_output.close();
+    if (m_output.fail())
+        return Result(Result::FileError);
+    return {};
+}
+
+ResultOr<void> TableExporter::flush()
+{
+    m_output.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    if (!m_output.good())
+        return Result(Result::FileError);
+
+    // The capacity of the buffer is kept, so it is never allocated again.
+    m_buffer.clear();
+    return {};
+}
+
+} // namespace Octopus
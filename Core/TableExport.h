@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Result.h"
+#include "Table.h"
+
+namespace Octopus
+{
+
+enum class TableExportFormat : u8
+{
+    /// Comma-separated values, with a header line that contains the names of the fields.
+    CSV,
+    /// One JSON object per line.
+    JSONLines,
+};
+
+///
+/// Writes table entries to a file, in a format that other tools can import. The entries are formatted directly
+/// into a fixed-size buffer, which is written to the file whenever it fills up, so the memory used doesn't depend
+/// on the number of exported entries.
+///
+class TableExporter
+{
+public:
+    OCT_NONCOPYABLE(TableExporter)
+    OCT_NONMOVABLE(TableExporter)
+    ~TableExporter() = default;
+
+public:
+    static ResultOr<OwnPtr<TableExporter>> create(const String& filepath, TableExportFormat format);
+
+    /// Accepts 'csv' and 'jsonl'.
+    static ResultOr<TableExportFormat> parse_format(StringView format_name);
+
+    /// The ticket code is written in the format of the snapshot that holds the entry.
+    ResultOr<void> write_entry(const TableSnapshot& table_snapshot, TicketID ticket_id, const TableEntry& entry);
+
+    /// Writes the remaining buffered entries to the file. Must be called after all entries are written.
+    ResultOr<void> finish();
+
+    NODISCARD ALWAYS_INLINE usize exported_entry_count() const { return m_exported_entry_count; }
+
+private:
+    explicit TableExporter(TableExportFormat format)
+        : m_format(format)
+    {
+    }
+
+    ResultOr<void> flush();
+
+private:
+    TableExportFormat m_format;
+    std::ofstream m_output;
+    String m_buffer;
+    usize m_exported_entry_count = 0;
+};
+
+} // namespace Octopus
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace Octopus;
+using namespace std::string_view_literals;
+
+/// The output buffer is followed by these bytes, which must still be intact after decompressing, so that writing past
+/// the end of the output is detected without a sanitizer.
+static constexpr usize guard_size = 64;
+static constexpr char guard_byte = '\x5A';
+static constexpr usize max_truncation_count = 512;
+
+static bool decompress_into_guarded_buffer(
+    BlockCompression compression,
+    StringView compressed_block,
+    usize size,
+    String& out_block
+)
+{
+    String buffer(size + guard_size, guard_byte);
+    const bool is_valid = !decompress_block(compression, compressed_block, Span<char>(buffer.data(), size)).is_result();
+
+    for (usize index = size; index < buffer.size(); ++index)
+    {
+        if (buffer[index] != guard_byte)
+        {
+            std::fprintf(stderr, "Decompressing a block of %zu bytes wrote past the end of the output.\n", size);
+            return false;
+        }
+    }
+
+    buffer.resize(size);
+    out_block = buffer;
+    return is_valid;
+}
+
+static bool check_round_trip(const char* name, BlockCompression compression, StringView block)
+{
+    String compressed_block;
+    compress_block(compression, block, compressed_block);
+
+    String decompressed_block;
+    if (!decompress_into_guarded_buffer(compression, compressed_block, block.size(), decompressed_block) ||
+        decompressed_block != block)
+    {
+        std::fprintf(
+            stderr,
+            "The %s block (%zu bytes) didn't survive a round trip through '%s'.\n",
+            name,
+            block.size(),
+            get_block_compression_name(compression).data()
+        );
+        return false;
+    }
+
+    // Every shorter block ends before all of the output is produced, so it must be rejected. Only some of the
+    // lengths of the large blocks are tried, as every try decompresses the whole block again.
+    const usize truncation_step = std::max<usize>(compressed_block.size() / max_truncation_count, 1);
+    for (usize size = 0; size < compressed_block.size(); size += truncation_step)
+    {
+        if (decompress_into_guarded_buffer(compression, StringView(compressed_block).substr(0, size), block.size(),
+                                           decompressed_block))
+        {
+            std::fprintf(stderr, "The %s block was accepted after being truncated to %zu bytes.\n", name, size);
+            return false;
+        }
+    }
+
+    // The size of the original block is stored next to the compressed block, so a wrong size is also corruption.
+    const bool accepts_smaller_size =
+        !block.empty() &&
+        decompress_into_guarded_buffer(compression, compressed_block, block.size() - 1, decompressed_block);
+    if (accepts_smaller_size ||
+        decompress_into_guarded_buffer(compression, compressed_block, block.size() + 1, decompressed_block))
+    {
+        std::fprintf(stderr, "The %s block was accepted with the wrong decompressed size.\n", name);
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_compresses(const char* name, StringView block)
+{
+    String compressed_block;
+    compress_block(BlockCompression::LZ4, block, compressed_block);
+    if (compressed_block.size() * 4 > block.size())
+    {
+        std::fprintf(
+            stderr,
+            "The %s block was only compressed from %zu to %zu bytes.\n",
+            name,
+            block.size(),
+            compressed_block.size()
+        );
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_hand_written_lz4_block(const char* name, StringView compressed_block, StringView expected_block)
+{
+    String decompressed_block;
+    if (!decompress_into_guarded_buffer(BlockCompression::LZ4, compressed_block, expected_block.size(),
+                                        decompressed_block) ||
+        decompressed_block != expected_block)
+    {
+        std::fprintf(stderr, "The hand-written %s block wasn't decompressed as expected.\n", name);
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_corrupted_lz4_block(const char* name, StringView compressed_block, usize size)
+{
+    String decompressed_block;
+    if (decompress_into_guarded_buffer(BlockCompression::LZ4, compressed_block, size, decompressed_block))
+    {
+        std::fprintf(stderr, "The corrupted block (%s) was accepted.\n", name);
+        return false;
+    }
+
+    return true;
+}
+
+/// Built like the blocks of an archive: short records whose names repeat every few records.
+static String create_archive_like_block()
+{
+    static constexpr StringView names[] = { "Popescu Ion", "Ionescu Maria-Elena", "Georgescu Andrei", "Dumitru Ana" };
+
+    String block;
+    for (usize record_index = 0; record_index < 1024; ++record_index)
+    {
+        block.push_back(static_cast<char>(1 + record_index % 3));
+        block.push_back(static_cast<char>(9 + record_index % 4));
+        block.push_back(static_cast<char>('A' + record_index % 6));
+        block.append(names[record_index % 4]);
+    }
+    return block;
+}
+
+int main()
+{
+    std::mt19937_64 random_engine(42);
+    String random_block(100000, '\0');
+    for (char& byte : random_block)
+        byte = static_cast<char>(random_engine());
+
+    String repeated_random_block = random_block.substr(0, 1000);
+    while (repeated_random_block.size() < 100000)
+        repeated_random_block.append(random_block.substr(0, 1000));
+
+    String repeated_pattern_block;
+    while (repeated_pattern_block.size() < 5000)
+        repeated_pattern_block.append("abc");
+
+    const String archive_like_block = create_archive_like_block();
+    const String run_block(70000, 'x');
+
+    struct NamedBlock
+    {
+        const char* name;
+        StringView block;
+    };
+
+    // The tiny blocks are around the 12 bytes below which LZ4 only stores literals. The runs and the repeated
+    // pattern are compressed into matches that overlap the bytes they produce.
+    const NamedBlock blocks[] = {
+        { "empty", "" },
+        { "one byte", "a" },
+        { "tiny", "abcabcabcab" },
+        { "smallest compressible", "abcabcabcabca" },
+        { "tiny run", "aaaaaaaaaaaaaaaaaaaa" },
+        { "incompressible", random_block },
+        { "repeated incompressible", repeated_random_block },
+        { "repeated pattern", repeated_pattern_block },
+        { "run", run_block },
+        { "archive-like", archive_like_block },
+    };
+
+    for (const NamedBlock& named_block : blocks)
+    {
+        for (const BlockCompression compression : { BlockCompression::None, BlockCompression::LZ4 })
+        {
+            if (!check_round_trip(named_block.name, compression, named_block.block))
+                return 1;
+        }
+    }
+
+    if (!check_compresses("repeated incompressible", repeated_random_block) ||
+        !check_compresses("repeated pattern", repeated_pattern_block) || !check_compresses("run", run_block) ||
+        !check_compresses("archive-like", archive_like_block))
+        return 1;
+
+    // Written by hand, so the decoder isn't only checked against blocks of the compressor. The match copies the two
+    // literals five times, starting two bytes behind the output; the extra 255 bytes of the second match are encoded
+    // in a length byte of 255 followed by a zero.
+    if (!check_hand_written_lz4_block("overlapping match", "\x26" "ab" "\x02\x00" "\x50" "xxxxx"sv,
+                                      "ababababab" "ab" "xxxxx"))
+        return 1;
+    if (!check_hand_written_lz4_block("long match",
+                                      "\x1F" "a" "\x01\x00" "\xFF\x00" "\x50" "xxxxx"sv,
+                                      String(1 + 4 + 15 + 255, 'a') + "xxxxx"))
+        return 1;
+
+    // Each of these reads or writes outside of the buffers if the decoder trusts it.
+    if (!check_corrupted_lz4_block("match offset of zero", "\x20" "ab" "\x00\x00" "\x50" "xxxxx"sv, 11))
+        return 1;
+    if (!check_corrupted_lz4_block("match before the output", "\x20" "ab" "\x03\x00" "\x50" "xxxxx"sv, 11))
+        return 1;
+    if (!check_corrupted_lz4_block("match past the output", "\x2F" "ab" "\x01\x00" "\x10" "\x50" "xxxxx"sv, 11))
+        return 1;
+    if (!check_corrupted_lz4_block("literals past the input", "\xF0" "\x20" "abc"sv, 100))
+        return 1;
+    if (!check_corrupted_lz4_block("literals past the output", "\x50" "xxxxx"sv, 4))
+        return 1;
+    if (!check_corrupted_lz4_block("unterminated length", "\xF0" "\xFF\xFF"sv, 600))
+        return 1;
+    if (!check_corrupted_lz4_block("missing match offset", "\x20" "ab" "\x01"sv, 7))
+        return 1;
+
+    return 0;
+}
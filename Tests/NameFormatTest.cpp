@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "NameFormat.h"
+
+#include <cctype>
+#include <cstdio>
+#include <random>
+
+using namespace Octopus;
+
+/// The implementation that was used before the names were formatted in place. The characters are converted to
+/// unsigned char before being classified, as the <cctype> functions don't accept negative values.
+static ResultOr<void> format_name_string_reference(String& name)
+{
+    for (usize index = 0; index < name.size(); ++index)
+        name[index] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[index])));
+
+    bool character_must_be_uppercase = true;
+    char last_character = '-';
+
+    String formatted_name = String();
+    for (usize index = 0; index < name.size(); ++index)
+    {
+        auto character = name[index];
+        const bool is_letter = std::isalpha(static_cast<unsigned char>(character)) != 0;
+        if (character != '-' && character != ' ' && !is_letter)
+            return Result(Result::InvalidString);
+
+        if (is_letter)
+        {
+            if (character_must_be_uppercase)
+            {
+                character = static_cast<char>(std::toupper(static_cast<unsigned char>(character)));
+                character_must_be_uppercase = false;
+            }
+            else
+            {
+                character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+            }
+        }
+        else
+        {
+            character_must_be_uppercase = true;
+            if (last_character == '-')
+                continue;
+        }
+
+        last_character = character;
+        formatted_name.push_back(character);
+    }
+
+    if ((last_character == '-' || last_character == ' ') && !formatted_name.empty())
+        formatted_name.pop_back();
+
+    name = formatted_name;
+    return {};
+}
+
+/// Letters, separators, and the characters that surround the letters in ASCII, plus a few that aren't ASCII at all.
+static constexpr char s_alphabet[] = { 'a', 'Z', 'm', '-', ' ', 'z', 'A', '@', '[', '`', '{', '.', '0', '\t', '\x7F',
+                                       '\x80', '\xC8', '\xFF' };
+static constexpr usize s_alphabet_size = sizeof(s_alphabet);
+/// The first characters of the alphabet are the ones that a valid name is made of.
+static constexpr usize s_name_alphabet_size = 6;
+
+static constexpr usize exhaustive_max_length = 5;
+static constexpr usize random_name_count = 200000;
+/// Longer than two vector blocks, so that the characters carried between the blocks are also checked.
+static constexpr usize random_name_max_length = 40;
+
+static bool check_name(const String& name)
+{
+    String expected_name = name;
+    const bool expected_is_valid = !format_name_string_reference(expected_name).is_result();
+
+    for (const NameFormatPath path : { NameFormatPath::Scalar, NameFormatPath::SSE2 })
+    {
+        if (!is_name_format_path_available(path))
+            continue;
+
+        String formatted_name = name;
+        const bool is_valid = !format_name_string(formatted_name, path).is_result();
+        if (is_valid != expected_is_valid || (is_valid && formatted_name != expected_name))
+        {
+            std::fprintf(
+                stderr,
+                "The name '%s' was formatted as '%s' (valid: %d) instead of '%s' (valid: %d), by the %s path.\n",
+                name.c_str(),
+                formatted_name.c_str(),
+                is_valid,
+                expected_name.c_str(),
+                expected_is_valid,
+                path == NameFormatPath::SSE2 ? "SSE2" : "scalar"
+            );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_all_short_names(String& name, usize length)
+{
+    if (!check_name(name))
+        return false;
+    if (name.size() == length)
+        return true;
+
+    for (const char character : s_alphabet)
+    {
+        name.push_back(character);
+        const bool is_valid = check_all_short_names(name, length);
+        name.pop_back();
+        if (!is_valid)
+            return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    String name;
+    if (!check_all_short_names(name, exhaustive_max_length))
+        return 1;
+
+    // Most of the random names are valid, so that the formatting itself is checked and not only the rejection.
+    std::mt19937_64 random_engine(42);
+    for (usize name_index = 0; name_index < random_name_count; ++name_index)
+    {
+        const usize length = random_engine() % (random_name_max_length + 1);
+        const usize alphabet_size = (random_engine() % 4 == 0) ? s_alphabet_size : s_name_alphabet_size;
+
+        name.clear();
+        for (usize index = 0; index < length; ++index)
+            name.push_back(s_alphabet[random_engine() % alphabet_size]);
+
+        if (!check_name(name))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2023 Traian Avram. All rights reserved.
+ * SPDX-License-Identifier: MIT.
+ */
+
+#include "Checksum.h"
+#include "Table.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace Octopus;
+
+/// The database file is emitted in chunks of at least 4096 entries, so this many entries are saved in several chunks.
+static constexpr usize multiple_chunks_entry_count = 3 * 4096 + 100;
+static constexpr usize single_chunk_entry_count = 100;
+
+/// Every index gets a distinct name, as the table rejects entries with the same name and class.
+static String make_unique_name(usize index)
+{
+    String name = "N";
+    do
+    {
+        name.push_back(static_cast<char>('a' + index % 26));
+        index /= 26;
+    } while (index > 0);
+    return name;
+}
+
+static ResultOr<void> check_round_trip(const String& filepath, usize entry_count)
+{
+    TRY_ASSIGN(OwnPtr<Table> table, Table::create_new());
+    for (usize index = 0; index < entry_count; ++index)
+    {
+        TableEntry entry;
+        entry.first_name = make_unique_name(index);
+        entry.last_name = make_unique_name(index / 7);
+        entry.grade = static_cast<u8>(ALLOWED_GRADE_LOW + index % 4);
+        entry.grade_id = static_cast<char>(ALLOWED_GRADE_ID_LOW + index % 6);
+        TRY(table->insert_entry(std::move(entry)));
+    }
+    TRY(table->save_to_file(filepath));
+
+    TRY_ASSIGN(const OwnPtr<Table> loaded_table, Table::create_from_file(filepath));
+    TRY_ASSIGN(const usize loaded_entry_count, loaded_table->entry_count());
+    if (loaded_entry_count != entry_count)
+    {
+        std::fprintf(stderr, "Loaded %zu of the %zu saved entries.\n", loaded_entry_count, entry_count);
+        return Result(Result::UnknownError);
+    }
+
+    // The checksum written while saving must match the one computed while loading, or the entries are validated
+    // again, which is what a file that was saved by us must avoid.
+    if (!loaded_table->is_loaded_file_verified())
+    {
+        std::fprintf(stderr, "The checksum of the %zu saved entries doesn't match when loading.\n", entry_count);
+        return Result(Result::UnknownError);
+    }
+
+    return {};
+}
+
+/// A file whose checksum matches its entries isn't formatted again, but an entry with a class outside of the allowed
+/// range must still be rejected, as the class indexes the statistics of the table.
+static ResultOr<void> check_invalid_class_is_rejected(const String& filepath)
+{
+    TRY_ASSIGN(OwnPtr<Table> table, Table::create_new());
+    TableEntry entry;
+    entry.first_name = "Ion";
+    entry.last_name = "Popescu";
+    entry.grade = 11;
+    entry.grade_id = 'C';
+    TRY(table->insert_entry(std::move(entry)));
+    TRY(table->save_to_file(filepath));
+
+    std::ifstream input(filepath, std::ios::binary);
+    String text = String(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    input.close();
+
+    const StringView entries_key = "entries:\n";
+    const usize entries_offset = text.find(entries_key);
+    const usize grade_offset = text.find("grade: 11");
+    const usize checksum_offset = text.find("entries_crc32c: ");
+    if (entries_offset == String::npos || grade_offset == String::npos || checksum_offset == String::npos)
+    {
+        std::fprintf(stderr, "The saved database file doesn't have the expected layout.\n");
+        return Result(Result::UnknownError);
+    }
+
+    // Sign the tampered entries with a matching checksum, as a crafted file would.
+    text.replace(grade_offset, 9, "grade: 8");
+    const usize checksum_value_offset = checksum_offset + StringView("entries_crc32c: ").size();
+    const usize checksum_value_end = text.find('\n', checksum_value_offset);
+    const u32 entries_crc32c = compute_crc32c(StringView(text).substr(entries_offset + entries_key.size()));
+    text.replace(checksum_value_offset, checksum_value_end - checksum_value_offset, std::to_string(entries_crc32c));
+
+    std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+    output.write(text.data(), static_cast<std::streamsize>(text.size()));
+    output.close();
+
+    auto result_or_table = Table::create_from_file(filepath);
+    if (!result_or_table.is_result())
+    {
+        std::fprintf(stderr, "A verified database file with an invalid grade was loaded.\n");
+        return Result(Result::UnknownError);
+    }
+
+    return {};
+}
+
+int main()
+{
+    const String filepath = (std::filesystem::temp_directory_path() / "octopus_table_round_trip.yaml").string();
+
+    for (const usize entry_count : { single_chunk_entry_count, multiple_chunks_entry_count })
+    {
+        auto result = check_round_trip(filepath, entry_count);
+        if (result.is_result())
+        {
+            std::fprintf(
+                stderr,
+                "The round trip of %zu entries failed with result code: %u\n",
+                entry_count,
+                static_cast<u32>(result.release_result().get_code())
+            );
+            std::filesystem::remove(filepath);
+            return 1;
+        }
+    }
+
+    auto result = check_invalid_class_is_rejected(filepath);
+    std::filesystem::remove(filepath);
+    if (result.is_result())
+    {
+        std::fprintf(
+            stderr,
+            "The check of the invalid class failed with result code: %u\n",
+            static_cast<u32>(result.release_result().get_code())
+        );
+        return 1;
+    }
+
+    return 0;
+}